@@ -26,6 +26,33 @@
 #define EI_CLASSIFIER_MAX_OBJECT_DETECTION_COUNT 10
 #endif
 
+#define EI_CLASSIFIER_LAST_LAYER_UNKNOWN               -1
+#define EI_CLASSIFIER_LAST_LAYER_SSD                   1
+#define EI_CLASSIFIER_LAST_LAYER_FOMO                  2
+#define EI_CLASSIFIER_LAST_LAYER_YOLOV5                3
+#define EI_CLASSIFIER_LAST_LAYER_YOLOX                 4
+#define EI_CLASSIFIER_LAST_LAYER_YOLOV5_V5_DRPAI       5
+#define EI_CLASSIFIER_LAST_LAYER_YOLOV7                6
+#define EI_CLASSIFIER_LAST_LAYER_TAO_RETINANET         7
+#define EI_CLASSIFIER_LAST_LAYER_TAO_SSD               8
+#define EI_CLASSIFIER_LAST_LAYER_TAO_YOLOV3            9
+#define EI_CLASSIFIER_LAST_LAYER_TAO_YOLOV4            10
+#define EI_CLASSIFIER_LAST_LAYER_YOLOV2                11
+
+// YOLOv5 boxes are decoded into the result itself, one slot per output row
+#if ((EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_YOLOV5) || (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_YOLOV5_V5_DRPAI)) && defined(EI_CLASSIFIER_NN_OUTPUT_COUNT)
+#define EI_CLASSIFIER_YOLOV5_ROW_COUNT (EI_CLASSIFIER_NN_OUTPUT_COUNT / (5 + EI_CLASSIFIER_LABEL_COUNT))
+#if EI_CLASSIFIER_YOLOV5_ROW_COUNT > EI_CLASSIFIER_OBJECT_DETECTION_COUNT
+#define EI_CLASSIFIER_YOLOV5_MAX_BOXES EI_CLASSIFIER_YOLOV5_ROW_COUNT
+#else
+#define EI_CLASSIFIER_YOLOV5_MAX_BOXES EI_CLASSIFIER_OBJECT_DETECTION_COUNT
+#endif
+#endif
+
+// Scratch bytes per candidate of ei_run_nms() (see ei_nms.h): box, score and class of
+// the candidate, then order, selected index, selected class (int) and selected box and area (float)
+#define EI_NMS_SCRATCH_BYTES_PER_CANDIDATE ((4 * sizeof(int)) + (10 * sizeof(float)))
+
 typedef struct {
     const char *label;
     float value;
@@ -53,6 +80,9 @@ typedef struct {
     int64_t dsp_us;
     int64_t classification_us;
     int64_t anomaly_us;
+    int64_t invoke_us;
+    int64_t postprocessing_us;
+    int64_t nms_us;
 } ei_impulse_result_timing_t;
 
 typedef struct {
@@ -68,6 +98,13 @@ typedef struct {
     float anomaly;
     ei_impulse_result_timing_t timing;
     bool copy_output;
+#ifdef EI_CLASSIFIER_YOLOV5_MAX_BOXES
+    // storage for bounding_boxes, owned by whoever owns the result
+    ei_impulse_result_bounding_box_t yolov5_boxes[EI_CLASSIFIER_YOLOV5_MAX_BOXES];
+    // NMS scratch for yolov5_boxes, lent by the impulse handle for the current run
+    // (nullptr: NMS allocates it on the heap)
+    uint8_t *yolov5_nms_scratch;
+#endif
 #if EI_CLASSIFIER_HAS_VISUAL_ANOMALY
     ei_impulse_result_bounding_box_t *visual_ad_grid_cells;
     uint32_t visual_ad_count;
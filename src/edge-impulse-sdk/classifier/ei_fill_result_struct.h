@@ -28,6 +28,7 @@ using namespace ei;
 #include "edge-impulse-sdk/classifier/ei_classifier_types.h"
 #include "edge-impulse-sdk/classifier/ei_nms.h"
 #include "edge-impulse-sdk/dsp/ei_vector.h"
+#include <limits>
 
 #ifndef EI_HAS_OBJECT_DETECTION
     #if (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_SSD)
@@ -453,98 +454,256 @@ __attribute__((unused)) static EI_IMPULSE_ERROR fill_result_visual_ad_struct_f32
     return EI_IMPULSE_OK;
 }
 
-/**
-  * Fill the result structure from an unquantized output tensor
-  */
-__attribute__((unused)) static EI_IMPULSE_ERROR fill_result_struct_f32_yolov5(const ei_impulse_t *impulse,
-                                                                              const ei_learning_block_config_tflite_graph_t *block_config,
-                                                                              ei_impulse_result_t *result,
-                                                                              int version,
-                                                                              float *data,
-                                                                              size_t output_features_count,
-                                                                              bool debug = false) {
 #ifdef EI_HAS_YOLOV5
-    static std::vector<ei_impulse_result_bounding_box_t> results;
-    results.clear();
+/**
+ * Turn a YOLOv5 row (already dequantized) into a bounding box.
+ * Returns false if the box is empty or below the threshold
+ */
+__attribute__((unused)) static bool yolov5_decode_row(const ei_impulse_t *impulse,
+                                                      const ei_learning_block_config_tflite_graph_t *block_config,
+                                                      int version,
+                                                      float xc,
+                                                      float yc,
+                                                      float w,
+                                                      float h,
+                                                      float score,
+                                                      uint32_t label,
+                                                      ei_impulse_result_bounding_box_t *r) {
+    float x = xc - (w / 2.0f);
+    float y = yc - (h / 2.0f);
+    if (x < 0) {
+        x = 0;
+    }
+    if (y < 0) {
+        y = 0;
+    }
+    if (x + w > impulse->input_width) {
+        w = impulse->input_width - x;
+    }
+    if (y + h > impulse->input_height) {
+        h = impulse->input_height - y;
+    }
 
-    size_t col_size = 5 + impulse->label_count;
-    size_t row_count = output_features_count / col_size;
+    if (w < 0 || h < 0) {
+        return false;
+    }
+
+    if (!(score >= block_config->threshold && score <= 1.0f)) {
+        return false;
+    }
+
+    r->label = impulse->categories[label];
+
+    if (version != 5) {
+        x *= static_cast<float>(impulse->input_width);
+        y *= static_cast<float>(impulse->input_height);
+        w *= static_cast<float>(impulse->input_width);
+        h *= static_cast<float>(impulse->input_height);
+    }
+
+    r->x = static_cast<uint32_t>(x);
+    r->y = static_cast<uint32_t>(y);
+    r->width = static_cast<uint32_t>(w);
+    r->height = static_cast<uint32_t>(h);
+    r->value = score;
+
+    return true;
+}
+
+/**
+ * Lowest raw (quantized) score that can still pass the threshold once dequantized.
+ * One step of slack absorbs rounding, survivors get the exact float check
+ */
+template<typename T>
+__attribute__((unused)) static int32_t yolov5_raw_threshold(float threshold, float zero_point, float scale) {
+    const float lowest = static_cast<float>(std::numeric_limits<T>::lowest());
+    const float highest = static_cast<float>(std::numeric_limits<T>::max());
+
+    if (!(scale > 0.0f)) {
+        return static_cast<int32_t>(lowest);
+    }
+
+    float raw = floorf(zero_point + (threshold / scale)) - 1.0f;
+    raw = std::min(std::max(raw, lowest), highest + 1.0f);
+
+    return static_cast<int32_t>(raw);
+}
+
+/**
+ * Decode quantized YOLOv5 rows into a caller-owned buffer.
+ * Rows are rejected on the raw score, only survivors are dequantized
+ */
+template<typename T>
+__attribute__((unused)) static EI_IMPULSE_ERROR yolov5_decode_quantized(const ei_impulse_t *impulse,
+                                                                        const ei_learning_block_config_tflite_graph_t *block_config,
+                                                                        int version,
+                                                                        const T *data,
+                                                                        float zero_point,
+                                                                        float scale,
+                                                                        size_t output_features_count,
+                                                                        ei_impulse_result_bounding_box_t *boxes,
+                                                                        size_t boxes_capacity,
+                                                                        size_t *boxes_count) {
+    const size_t col_size = 5 + impulse->label_count;
+    const size_t row_count = output_features_count / col_size;
+    const int32_t raw_threshold = yolov5_raw_threshold<T>(block_config->threshold, zero_point, scale);
+
+    *boxes_count = 0;
 
     for (size_t ix = 0; ix < row_count; ix++) {
-        size_t base_ix = ix * col_size;
-        float xc = data[base_ix + 0];
-        float yc = data[base_ix + 1];
-        float w = data[base_ix + 2];
-        float h = data[base_ix + 3];
-        float x = xc - (w / 2.0f);
-        float y = yc - (h / 2.0f);
-        if (x < 0) {
-            x = 0;
+        const T *row = data + (ix * col_size);
+
+        if (static_cast<int32_t>(row[4]) < raw_threshold) {
+            continue;
         }
-        if (y < 0) {
-            y = 0;
+
+        uint32_t label = 0;
+        for (size_t lx = 0; lx < impulse->label_count; lx++) {
+            float l = (row[5 + lx] - zero_point) * scale;
+            if (l > 0.5f) {
+                label = lx;
+                break;
+            }
         }
-        if (x + w > impulse->input_width) {
-            w = impulse->input_width - x;
+
+        ei_impulse_result_bounding_box_t r;
+        bool found = yolov5_decode_row(impulse, block_config, version,
+                                       (row[0] - zero_point) * scale,
+                                       (row[1] - zero_point) * scale,
+                                       (row[2] - zero_point) * scale,
+                                       (row[3] - zero_point) * scale,
+                                       (row[4] - zero_point) * scale,
+                                       label,
+                                       &r);
+        if (!found) {
+            continue;
         }
-        if (y + h > impulse->input_height) {
-            h = impulse->input_height - y;
+
+        if (*boxes_count >= boxes_capacity) {
+            ei_printf("ERR: Too many YOLOv5 candidates (max %u)\n", (unsigned int)boxes_capacity);
+            return EI_IMPULSE_OUT_OF_MEMORY;
         }
 
-        if (w < 0 || h < 0) {
+        boxes[(*boxes_count)++] = r;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Decode float YOLOv5 rows into a caller-owned buffer
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR yolov5_decode_f32(const ei_impulse_t *impulse,
+                                                                  const ei_learning_block_config_tflite_graph_t *block_config,
+                                                                  int version,
+                                                                  const float *data,
+                                                                  size_t output_features_count,
+                                                                  ei_impulse_result_bounding_box_t *boxes,
+                                                                  size_t boxes_capacity,
+                                                                  size_t *boxes_count) {
+    const size_t col_size = 5 + impulse->label_count;
+    const size_t row_count = output_features_count / col_size;
+
+    *boxes_count = 0;
+
+    for (size_t ix = 0; ix < row_count; ix++) {
+        const float *row = data + (ix * col_size);
+
+        if (!(row[4] >= block_config->threshold)) {
             continue;
         }
 
-        float score = data[base_ix + 4];
-
         uint32_t label = 0;
         for (size_t lx = 0; lx < impulse->label_count; lx++) {
-            float l = data[base_ix + 5 + lx];
-            if (l > 0.5f) {
+            if (row[5 + lx] > 0.5f) {
                 label = lx;
                 break;
             }
         }
 
-        if (score >= block_config->threshold && score <= 1.0f) {
-            ei_impulse_result_bounding_box_t r;
-            r.label = impulse->categories[label];
-
-            if (version != 5) {
-                x *= static_cast<float>(impulse->input_width);
-                y *= static_cast<float>(impulse->input_height);
-                w *= static_cast<float>(impulse->input_width);
-                h *= static_cast<float>(impulse->input_height);
-            }
+        ei_impulse_result_bounding_box_t r;
+        if (!yolov5_decode_row(impulse, block_config, version, row[0], row[1], row[2], row[3], row[4], label, &r)) {
+            continue;
+        }
 
-            r.x = static_cast<uint32_t>(x);
-            r.y = static_cast<uint32_t>(y);
-            r.width = static_cast<uint32_t>(w);
-            r.height = static_cast<uint32_t>(h);
-            r.value = score;
-            results.push_back(r);
+        if (*boxes_count >= boxes_capacity) {
+            ei_printf("ERR: Too many YOLOv5 candidates (max %u)\n", (unsigned int)boxes_capacity);
+            return EI_IMPULSE_OUT_OF_MEMORY;
         }
+
+        boxes[(*boxes_count)++] = r;
     }
 
-    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse, &results, debug);
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Run NMS over the decoded boxes and point the result at them,
+ * padding with empty boxes up to the object detection count
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR yolov5_fill_result(const ei_impulse_t *impulse,
+                                                                   ei_impulse_result_t *result,
+                                                                   ei_impulse_result_bounding_box_t *boxes,
+                                                                   size_t boxes_capacity,
+                                                                   size_t boxes_count,
+                                                                   bool debug) {
+    if (ei_run_impulse_check_deadline() == EI_IMPULSE_CANCELED) {
+        return EI_IMPULSE_CANCELED;
+    }
+
+    uint64_t nms_start_us = ei_read_timer_us();
+
+#ifdef EI_CLASSIFIER_YOLOV5_MAX_BOXES
+    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse, boxes, &boxes_count, true, debug,
+                                          EI_CLASSIFIER_NMS_CLASS_AWARE,
+                                          result->yolov5_nms_scratch,
+                                          EI_CLASSIFIER_YOLOV5_MAX_BOXES);
+#else
+    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse, boxes, &boxes_count, true, debug);
+#endif
+
+    result->timing.nms_us = ei_read_timer_us() - nms_start_us;
+
     if (nms_res != EI_IMPULSE_OK) {
         return nms_res;
     }
 
     // if we didn't detect min required objects, fill the rest with fixed value
-    size_t added_boxes_count = results.size();
-    size_t min_object_detection_count = impulse->object_detection_count;
-    if (added_boxes_count < min_object_detection_count) {
-        results.resize(min_object_detection_count);
-        for (size_t ix = added_boxes_count; ix < min_object_detection_count; ix++) {
-            results[ix].value = 0.0f;
-        }
+    size_t min_object_detection_count = std::min((size_t)impulse->object_detection_count, boxes_capacity);
+    if (boxes_count < min_object_detection_count) {
+        memset(boxes + boxes_count, 0, (min_object_detection_count - boxes_count) * sizeof(ei_impulse_result_bounding_box_t));
+        boxes_count = min_object_detection_count;
     }
 
-    result->bounding_boxes = results.data();
-    result->bounding_boxes_count = results.size();
+    result->bounding_boxes = boxes;
+    result->bounding_boxes_count = boxes_count;
 
     return EI_IMPULSE_OK;
+}
+#endif // EI_HAS_YOLOV5
+
+/**
+  * Fill the result structure from an unquantized output tensor
+  */
+__attribute__((unused)) static EI_IMPULSE_ERROR fill_result_struct_f32_yolov5(const ei_impulse_t *impulse,
+                                                                              const ei_learning_block_config_tflite_graph_t *block_config,
+                                                                              ei_impulse_result_t *result,
+                                                                              int version,
+                                                                              float *data,
+                                                                              size_t output_features_count,
+                                                                              bool debug = false) {
+#ifdef EI_CLASSIFIER_YOLOV5_MAX_BOXES
+    const size_t capacity = EI_CLASSIFIER_YOLOV5_MAX_BOXES;
+    size_t boxes_count = 0;
+
+    EI_IMPULSE_ERROR decode_res = yolov5_decode_f32(impulse, block_config, version, data,
+                                                    output_features_count,
+                                                    result->yolov5_boxes, capacity, &boxes_count);
+    if (decode_res != EI_IMPULSE_OK) {
+        return decode_res;
+    }
+
+    return yolov5_fill_result(impulse, result, result->yolov5_boxes, capacity, boxes_count, debug);
 #else
     return EI_IMPULSE_LAST_LAYER_NOT_AVAILABLE;
 #endif
@@ -563,88 +722,18 @@ __attribute__((unused)) static EI_IMPULSE_ERROR fill_result_struct_quantized_yol
                                                                                     float scale,
                                                                                     size_t output_features_count,
                                                                                     bool debug = false) {
-#ifdef EI_HAS_YOLOV5
-    static std::vector<ei_impulse_result_bounding_box_t> results;
-    results.clear();
-
-    size_t col_size = 5 + impulse->label_count;
-    size_t row_count = output_features_count / col_size;
-
-    for (size_t ix = 0; ix < row_count; ix++) {
-        size_t base_ix = ix * col_size;
-        float xc = (data[base_ix + 0] - zero_point) * scale;
-        float yc = (data[base_ix + 1] - zero_point) * scale;
-        float w = (data[base_ix + 2] - zero_point) * scale;
-        float h = (data[base_ix + 3] - zero_point) * scale;
-        float x = xc - (w / 2.0f);
-        float y = yc - (h / 2.0f);
-        if (x < 0) {
-            x = 0;
-        }
-        if (y < 0) {
-            y = 0;
-        }
-        if (x + w > impulse->input_width) {
-            w = impulse->input_width - x;
-        }
-        if (y + h > impulse->input_height) {
-            h = impulse->input_height - y;
-        }
-
-        if (w < 0 || h < 0) {
-            continue;
-        }
-
-        float score = (data[base_ix + 4] - zero_point) * scale;
-
-        uint32_t label = 0;
-        for (size_t lx = 0; lx < impulse->label_count; lx++) {
-            float l = (data[base_ix + 5 + lx] - zero_point) * scale;
-            if (l > 0.5f) {
-                label = lx;
-                break;
-            }
-        }
-
-        if (score >= block_config->threshold && score <= 1.0f) {
-            ei_impulse_result_bounding_box_t r;
-            r.label = ei_classifier_inferencing_categories[label];
-
-            if (version != 5) {
-                x *= static_cast<float>(impulse->input_width);
-                y *= static_cast<float>(impulse->input_height);
-                w *= static_cast<float>(impulse->input_width);
-                h *= static_cast<float>(impulse->input_height);
-            }
-
-            r.x = static_cast<uint32_t>(x);
-            r.y = static_cast<uint32_t>(y);
-            r.width = static_cast<uint32_t>(w);
-            r.height = static_cast<uint32_t>(h);
-            r.value = score;
-            results.push_back(r);
-        }
-    }
-
-    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse, &results, debug);
-    if (nms_res != EI_IMPULSE_OK) {
-        return nms_res;
-    }
-
-    // if we didn't detect min required objects, fill the rest with fixed value
-    size_t added_boxes_count = results.size();
-    size_t min_object_detection_count = impulse->object_detection_count;
-    if (added_boxes_count < min_object_detection_count) {
-        results.resize(min_object_detection_count);
-        for (size_t ix = added_boxes_count; ix < min_object_detection_count; ix++) {
-            results[ix].value = 0.0f;
-        }
+#ifdef EI_CLASSIFIER_YOLOV5_MAX_BOXES
+    const size_t capacity = EI_CLASSIFIER_YOLOV5_MAX_BOXES;
+    size_t boxes_count = 0;
+
+    EI_IMPULSE_ERROR decode_res = yolov5_decode_quantized(impulse, block_config, version, data,
+                                                          zero_point, scale, output_features_count,
+                                                          result->yolov5_boxes, capacity, &boxes_count);
+    if (decode_res != EI_IMPULSE_OK) {
+        return decode_res;
     }
 
-    result->bounding_boxes = results.data();
-    result->bounding_boxes_count = results.size();
-
-    return EI_IMPULSE_OK;
+    return yolov5_fill_result(impulse, result, result->yolov5_boxes, capacity, boxes_count, debug);
 #else
     return EI_IMPULSE_LAST_LAYER_NOT_AVAILABLE;
 #endif
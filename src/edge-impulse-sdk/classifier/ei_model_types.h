@@ -19,6 +19,7 @@
 #define _EDGE_IMPULSE_MODEL_TYPES_H_
 
 #include <stdint.h>
+#include <new>
 
 #include "edge-impulse-sdk/classifier/ei_classifier_types.h"
 #include "edge-impulse-sdk/dsp/ei_dsp_handle.h"
@@ -55,18 +56,7 @@
 #define EI_CLASSIFIER_DATATYPE_FLOAT32           1
 #define EI_CLASSIFIER_DATATYPE_INT8              9
 
-#define EI_CLASSIFIER_LAST_LAYER_UNKNOWN               -1
-#define EI_CLASSIFIER_LAST_LAYER_SSD                   1
-#define EI_CLASSIFIER_LAST_LAYER_FOMO                  2
-#define EI_CLASSIFIER_LAST_LAYER_YOLOV5                3
-#define EI_CLASSIFIER_LAST_LAYER_YOLOX                 4
-#define EI_CLASSIFIER_LAST_LAYER_YOLOV5_V5_DRPAI       5
-#define EI_CLASSIFIER_LAST_LAYER_YOLOV7                6
-#define EI_CLASSIFIER_LAST_LAYER_TAO_RETINANET         7
-#define EI_CLASSIFIER_LAST_LAYER_TAO_SSD               8
-#define EI_CLASSIFIER_LAST_LAYER_TAO_YOLOV3            9
-#define EI_CLASSIFIER_LAST_LAYER_TAO_YOLOV4            10
-#define EI_CLASSIFIER_LAST_LAYER_YOLOV2                11
+// EI_CLASSIFIER_LAST_LAYER_* are defined in ei_classifier_types.h
 
 #define EI_CLASSIFIER_IMAGE_SCALING_NONE          0
 #define EI_CLASSIFIER_IMAGE_SCALING_0_255         1
@@ -85,6 +75,7 @@
 #define EI_CLASSIFIER_CLASSIFICATION_MODE_DSP                 7
 
 struct ei_impulse;
+class ei_impulse_handle_t;
 
 typedef struct {
     ei::matrix_t* matrix;
@@ -122,7 +113,7 @@ typedef struct {
 typedef struct {
     uint32_t blockId;
     bool keep_output;
-    EI_IMPULSE_ERROR (*infer_fn)(const ei_impulse *impulse, ei_feature_t *fmatrix, uint32_t learn_block_index, uint32_t* input_block_ids, uint32_t input_block_ids_size, ei_impulse_result_t *result, void *config, bool debug);
+    EI_IMPULSE_ERROR (*infer_fn)(ei_impulse_handle_t *handle, ei_feature_t *fmatrix, uint32_t learn_block_index, uint32_t* input_block_ids, uint32_t input_block_ids_size, ei_impulse_result_t *result, void *config, bool debug);
     void *config;
     int image_scaling;
     const uint32_t* input_block_ids;
@@ -130,6 +121,15 @@ typedef struct {
     uint32_t output_features_count;
 } ei_learning_block_t;
 
+/**
+ * Runtime state of a learning block that outlives a single inference
+ * (e.g. a resident EON graph). Owned by the impulse state, released via free_fn.
+ */
+typedef struct {
+    void *ctx;
+    void (*free_fn)(void *ctx);
+} ei_learning_block_state_t;
+
 typedef struct {
     uint16_t implementation_version;
     uint8_t input_datatype;
@@ -249,12 +249,32 @@ typedef struct ei_impulse {
     ei_object_detection_nms_config_t object_detection_nms;
 } ei_impulse_t;
 
+/**
+ * Channel value -> quantized value table for uint8 image inputs, per model input
+ * channel. Only valid for the scale, zero point and scaling it was built with.
+ */
+typedef struct {
+    float scale;
+    float zero_point;
+    int image_scaling; // -1 until built
+    uint8_t values[3][256];
+} ei_image_quantize_lut_t;
+
 class ei_impulse_state_t {
 typedef DspHandle* _dsp_handle_ptr_t;
 public:
     const ei_impulse_t *impulse; // keep a pointer to the impulse
     _dsp_handle_ptr_t *dsp_handles;
+    ei_learning_block_state_t *learning_block_states;
     bool is_temp_handle = false; // to know if we're using the old (stateless) API
+    bool is_resident = false; // keep learning block runtimes alive between inferences
+    uint32_t deadline_us = 0; // inference budget from the start of each run, 0 = no deadline
+    ei_feature_t *features = nullptr; // one per DSP + learning block
+    ei::matrix_t *feature_matrices = nullptr; // views into feature_arena
+    float *feature_arena = nullptr;
+    size_t feature_arena_size = 0; // in floats
+    uint8_t *nms_scratch = nullptr; // YOLOv5 NMS candidates and selection, see get_nms_scratch()
+    ei_image_quantize_lut_t *image_quantize_lut = nullptr; // see get_image_quantize_lut()
     ei_impulse_state_t(const ei_impulse_t *impulse)
         : impulse(impulse)
     {
@@ -263,6 +283,12 @@ public:
         for(size_t ix = 0; ix < num_dsp_blocks; ix++) {
             dsp_handles[ix] = nullptr;
         }
+        const auto num_learning_blocks = impulse->learning_blocks_size;
+        learning_block_states = (ei_learning_block_state_t*)ei_malloc(sizeof(ei_learning_block_state_t)*num_learning_blocks);
+        for(size_t ix = 0; ix < num_learning_blocks; ix++) {
+            learning_block_states[ix].ctx = nullptr;
+            learning_block_states[ix].free_fn = nullptr;
+        }
     }
 
     DspHandle* get_dsp_handle(size_t ix) {
@@ -282,6 +308,133 @@ public:
         }
     }
 
+    /**
+     * Release the runtime state of all learning blocks (tensor arenas, graph contexts).
+     * They are set up again on the next inference.
+     */
+    void reset_learning_blocks()
+    {
+        for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
+            if (learning_block_states[ix].ctx != nullptr) {
+                learning_block_states[ix].free_fn(learning_block_states[ix].ctx);
+                learning_block_states[ix].ctx = nullptr;
+                learning_block_states[ix].free_fn = nullptr;
+            }
+        }
+    }
+
+    /**
+     * Get the feature matrices of all blocks for the next run.
+     * Feature memory is planned once (DSP outputs, then kept learning block outputs)
+     * and owned by the handle, every call only resets the views and zeroes the arena.
+     * Returns nullptr if the arena cannot be allocated.
+     */
+    ei_feature_t* get_features(bool keep_learning_outputs)
+    {
+        const size_t block_num = impulse->dsp_blocks_size + impulse->learning_blocks_size;
+
+        if (feature_arena == nullptr) {
+            size_t arena_size = 0;
+            for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
+                arena_size += impulse->dsp_blocks[ix].n_output_features;
+            }
+            for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
+                if (impulse->learning_blocks[ix].keep_output) {
+                    arena_size += impulse->learning_blocks[ix].output_features_count;
+                }
+            }
+
+            features = (ei_feature_t*)ei_calloc(block_num, sizeof(ei_feature_t));
+            feature_matrices = (ei::matrix_t*)ei_calloc(block_num, sizeof(ei::matrix_t));
+            feature_arena = (float*)ei_calloc(arena_size > 0 ? arena_size : 1, sizeof(float));
+
+            if (!features || !feature_matrices || !feature_arena) {
+                free_features();
+                return nullptr;
+            }
+
+            feature_arena_size = arena_size;
+
+            // views only, the arena is never freed through them
+            for (size_t ix = 0; ix < block_num; ix++) {
+                new (&feature_matrices[ix]) ei::matrix_t(1, 1, feature_arena);
+            }
+        }
+        else {
+            memset(feature_arena, 0, feature_arena_size * sizeof(float));
+        }
+
+        size_t offset = 0;
+        for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
+            offset += set_feature_view(ix, impulse->dsp_blocks[ix].blockId, impulse->dsp_blocks[ix].n_output_features, offset);
+        }
+        for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
+            const ei_learning_block_t &block = impulse->learning_blocks[ix];
+            const size_t feature_ix = impulse->dsp_blocks_size + ix;
+
+            if (block.keep_output) {
+                // always reserved in the arena, so offsets don't depend on keep_learning_outputs
+                offset += set_feature_view(feature_ix, block.blockId, block.output_features_count, offset);
+            }
+
+            if (!block.keep_output || !keep_learning_outputs) {
+                features[feature_ix].matrix = nullptr;
+                features[feature_ix].blockId = 0;
+            }
+        }
+
+        return features;
+    }
+
+#ifdef EI_CLASSIFIER_YOLOV5_MAX_BOXES
+    /**
+     * Get the NMS scratch for EI_CLASSIFIER_YOLOV5_MAX_BOXES candidates.
+     * Allocated on first use and owned by the handle, so concurrent handles don't share it.
+     * Returns nullptr if it cannot be allocated (NMS then uses the heap on every run).
+     */
+    uint8_t* get_nms_scratch()
+    {
+        if (nms_scratch == nullptr) {
+            nms_scratch = (uint8_t*)ei_malloc(EI_CLASSIFIER_YOLOV5_MAX_BOXES * EI_NMS_SCRATCH_BYTES_PER_CANDIDATE);
+        }
+        return nms_scratch;
+    }
+#endif
+
+    /**
+     * Get the table to quantize image features into a uint8 input tensor.
+     * Allocated on first use and owned by the handle, so concurrent handles don't share it.
+     * Returns nullptr if it cannot be allocated (the table is then rebuilt on every run).
+     */
+    ei_image_quantize_lut_t* get_image_quantize_lut()
+    {
+        if (image_quantize_lut == nullptr) {
+            image_quantize_lut = (ei_image_quantize_lut_t*)ei_malloc(sizeof(ei_image_quantize_lut_t));
+            if (image_quantize_lut) {
+                image_quantize_lut->image_scaling = -1;
+            }
+        }
+        return image_quantize_lut;
+    }
+
+    void free_features()
+    {
+        if (feature_matrices) {
+            for (size_t ix = 0; ix < impulse->dsp_blocks_size + impulse->learning_blocks_size; ix++) {
+                if (feature_matrices[ix].buffer) {
+                    feature_matrices[ix].~ei_matrix();
+                }
+            }
+        }
+        ei_free(features);
+        ei_free(feature_matrices);
+        ei_free(feature_arena);
+        features = nullptr;
+        feature_matrices = nullptr;
+        feature_arena = nullptr;
+        feature_arena_size = 0;
+    }
+
     void* operator new(size_t size) {
         return ei_malloc(size);
     }
@@ -298,10 +451,27 @@ public:
         ei_free(ptr);
     }
 
+private:
+    size_t set_feature_view(size_t ix, uint32_t block_id, size_t size, size_t offset)
+    {
+        feature_matrices[ix].buffer = feature_arena + offset;
+        feature_matrices[ix].rows = 1;
+        feature_matrices[ix].cols = size;
+        features[ix].matrix = &feature_matrices[ix];
+        features[ix].blockId = block_id;
+        return size;
+    }
+
+public:
     ~ei_impulse_state_t()
     {
         reset();
+        reset_learning_blocks();
+        free_features();
+        ei_free(nms_scratch);
+        ei_free(image_quantize_lut);
         ei_free(dsp_handles);
+        ei_free(learning_block_states);
     }
 };
 
@@ -28,234 +28,192 @@
 
 #if (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_YOLOV5) || (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_YOLOV5_V5_DRPAI) || (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_YOLOX) || (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_TAO_RETINANET) || (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_TAO_SSD) || (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_TAO_YOLOV3) || (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_TAO_YOLOV4) || (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_YOLOV2)
 
-// The code below comes from tensorflow/lite/kernels/internal/reference/non_max_suppression.h
-// Copyright 2019 The TensorFlow Authors.  All rights reserved.
-// Licensed under the Apache License, Version 2.0
 #include <algorithm>
 #include <cmath>
-#include <deque>
-#include <queue>
-
-// A pair of diagonal corners of the box.
-struct BoxCornerEncoding {
-  float y1;
-  float x1;
-  float y2;
-  float x2;
-};
-
-static inline float ComputeIntersectionOverUnion(const float* boxes, const int i,
-                                          const int j) {
-  auto& box_i = reinterpret_cast<const BoxCornerEncoding*>(boxes)[i];
-  auto& box_j = reinterpret_cast<const BoxCornerEncoding*>(boxes)[j];
-  const float box_i_y_min = std::min<float>(box_i.y1, box_i.y2);
-  const float box_i_y_max = std::max<float>(box_i.y1, box_i.y2);
-  const float box_i_x_min = std::min<float>(box_i.x1, box_i.x2);
-  const float box_i_x_max = std::max<float>(box_i.x1, box_i.x2);
-  const float box_j_y_min = std::min<float>(box_j.y1, box_j.y2);
-  const float box_j_y_max = std::max<float>(box_j.y1, box_j.y2);
-  const float box_j_x_min = std::min<float>(box_j.x1, box_j.x2);
-  const float box_j_x_max = std::max<float>(box_j.x1, box_j.x2);
-
-  const float area_i =
-      (box_i_y_max - box_i_y_min) * (box_i_x_max - box_i_x_min);
-  const float area_j =
-      (box_j_y_max - box_j_y_min) * (box_j_x_max - box_j_x_min);
-  if (area_i <= 0 || area_j <= 0) return 0.0;
-  const float intersection_ymax = std::min<float>(box_i_y_max, box_j_y_max);
-  const float intersection_xmax = std::min<float>(box_i_x_max, box_j_x_max);
-  const float intersection_ymin = std::max<float>(box_i_y_min, box_j_y_min);
-  const float intersection_xmin = std::max<float>(box_i_x_min, box_j_x_min);
-  const float intersection_area =
-      std::max<float>(intersection_ymax - intersection_ymin, 0.0) *
-      std::max<float>(intersection_xmax - intersection_xmin, 0.0);
-  return intersection_area / (area_i + area_j - intersection_area);
+#include <vector>
+
+#ifndef EI_CLASSIFIER_NMS_CLASS_AWARE
+#define EI_CLASSIFIER_NMS_CLASS_AWARE 0
+#endif
+
+// order, selected index, selected class (int) + selected ymin, xmin, ymax, xmax, area (float)
+#define EI_NMS_SELECT_BYTES_PER_CANDIDATE ((3 * sizeof(int)) + (5 * sizeof(float)))
+
+/**
+ * Views into the NMS scratch memory.
+ * Selected boxes are kept as structure of arrays, so the IoU loop vectorizes
+ */
+typedef struct {
+    int *order;
+    int *selected;
+    int *selected_classes;
+    float *selected_ymin;
+    float *selected_xmin;
+    float *selected_ymax;
+    float *selected_xmax;
+    float *selected_area;
+} ei_nms_scratch_t;
+
+/**
+ * Carve the scratch views out of a single block of `capacity` candidates
+ */
+static inline void ei_nms_scratch_init(ei_nms_scratch_t *scratch, uint8_t *memory, size_t capacity) {
+    scratch->selected_ymin = (float*)memory;
+    scratch->selected_xmin = scratch->selected_ymin + capacity;
+    scratch->selected_ymax = scratch->selected_xmin + capacity;
+    scratch->selected_xmax = scratch->selected_ymax + capacity;
+    scratch->selected_area = scratch->selected_xmax + capacity;
+    scratch->order = (int*)(scratch->selected_area + capacity);
+    scratch->selected = scratch->order + capacity;
+    scratch->selected_classes = scratch->selected + capacity;
 }
 
-// Implements (Single-Class) Soft NMS (with Gaussian weighting).
-// Supports functionality of TensorFlow ops NonMaxSuppressionV4 & V5.
-// Reference: "Soft-NMS - Improving Object Detection With One Line of Code"
-//            [Bodla et al, https://arxiv.org/abs/1704.04503]
-// Implementation adapted from the TensorFlow NMS code at
-// tensorflow/core/kernels/non_max_suppression_op.cc.
-//
-// Arguments:
-//  boxes: box encodings in format [y1, x1, y2, x2], shape: [num_boxes, 4]
-//  num_boxes: number of candidates
-//  scores: scores for candidate boxes, in the same order. shape: [num_boxes]
-//  max_output_size: the maximum number of selections.
-//  iou_threshold: Intersection-over-Union (IoU) threshold for NMS
-//  score_threshold: All candidate scores below this value are rejected
-//  soft_nms_sigma: Soft NMS parameter, used for decaying scores
-//
-// Outputs:
-//  selected_indices: all the selected indices. Underlying array must have
-//    length >= max_output_size. Cannot be null.
-//  selected_scores: scores of selected indices. Defer from original value for
-//    Soft NMS. If not null, array must have length >= max_output_size.
-//  num_selected_indices: Number of selections. Only these many elements are
-//    set in selected_indices, selected_scores. Cannot be null.
-//
-// Assumes inputs are valid (for eg, iou_threshold must be >= 0).
-static inline void NonMaxSuppression(const float* boxes, const int num_boxes,
-                              const float* scores, const int max_output_size,
-                              const float iou_threshold,
-                              const float score_threshold,
-                              const float soft_nms_sigma, int* selected_indices,
-                              float* selected_scores,
-                              int* num_selected_indices) {
-  struct Candidate {
-    int index;
-    float score;
-    int suppress_begin_index;
-  };
+/**
+ * Hard NMS over `bb_count` candidates.
+ * Boxes are encoded as [y1, x1, y2, x2], candidates are visited by descending score
+ * (ties keep their original order) and are dropped when their IoU with an already
+ * selected box reaches the threshold. In class aware mode, only boxes of the same class
+ * suppress each other.
+ * Returns the same selections as TensorFlow's NonMaxSuppression with soft_nms_sigma = 0
+ */
+static EI_IMPULSE_ERROR ei_nms_select(
+    const float *boxes,
+    const float *scores,
+    const int *classes,
+    size_t bb_count,
+    float iou_threshold,
+    float score_threshold,
+    bool class_aware,
+    ei_nms_scratch_t *scratch,
+    size_t *selected_count) {
+
+    // insertion sort on the candidates above the score threshold
+    size_t candidates = 0;
+    for (size_t ix = 0; ix < bb_count; ix++) {
+        if (!(scores[ix] > score_threshold)) {
+            continue;
+        }
 
-  // Priority queue to hold candidates.
-  auto cmp = [](const Candidate bs_i, const Candidate bs_j) {
-    return bs_i.score < bs_j.score;
-  };
-  std::priority_queue<Candidate, std::deque<Candidate>, decltype(cmp)>
-      candidate_priority_queue(cmp);
-  // Populate queue with candidates above the score threshold.
-  for (int i = 0; i < num_boxes; ++i) {
-    if (scores[i] > score_threshold) {
-      candidate_priority_queue.emplace(Candidate({i, scores[i], 0}));
-    }
-  }
-
-  *num_selected_indices = 0;
-  int num_outputs = std::min(static_cast<int>(candidate_priority_queue.size()),
-                             max_output_size);
-  if (num_outputs == 0) return;
-
-  // NMS loop.
-  float scale = 0;
-  if (soft_nms_sigma > 0.0) {
-    scale = -0.5 / soft_nms_sigma;
-  }
-  while (*num_selected_indices < num_outputs &&
-         !candidate_priority_queue.empty()) {
-    Candidate next_candidate = candidate_priority_queue.top();
-    const float original_score = next_candidate.score;
-    candidate_priority_queue.pop();
-
-    // Overlapping boxes are likely to have similar scores, therefore we
-    // iterate through the previously selected boxes backwards in order to
-    // see if `next_candidate` should be suppressed. We also enforce a property
-    // that a candidate can be suppressed by another candidate no more than
-    // once via `suppress_begin_index` which tracks which previously selected
-    // boxes have already been compared against next_candidate prior to a given
-    // iteration.  These previous selected boxes are then skipped over in the
-    // following loop.
-    bool should_hard_suppress = false;
-    for (int j = *num_selected_indices - 1;
-         j >= next_candidate.suppress_begin_index; --j) {
-      const float iou = ComputeIntersectionOverUnion(
-          boxes, next_candidate.index, selected_indices[j]);
-
-      // First decide whether to perform hard suppression.
-      if (iou >= iou_threshold) {
-        should_hard_suppress = true;
-        break;
-      }
-
-      // Suppress score if NMS sigma > 0.
-      if (soft_nms_sigma > 0.0) {
-        next_candidate.score =
-            next_candidate.score * std::exp(scale * iou * iou);
-      }
-
-      // If score has fallen below score_threshold, it won't be pushed back into
-      // the queue.
-      if (next_candidate.score <= score_threshold) break;
+        size_t pos = candidates++;
+        while (pos > 0 && scores[scratch->order[pos - 1]] < scores[ix]) {
+            scratch->order[pos] = scratch->order[pos - 1];
+            pos--;
+        }
+        scratch->order[pos] = (int)ix;
     }
-    // If `next_candidate.score` has not dropped below `score_threshold`
-    // by this point, then we know that we went through all of the previous
-    // selections and can safely update `suppress_begin_index` to
-    // `selected.size()`. If on the other hand `next_candidate.score`
-    // *has* dropped below the score threshold, then since `suppress_weight`
-    // always returns values in [0, 1], further suppression by items that were
-    // not covered in the above for loop would not have caused the algorithm
-    // to select this item. We thus do the same update to
-    // `suppress_begin_index`, but really, this element will not be added back
-    // into the priority queue.
-    next_candidate.suppress_begin_index = *num_selected_indices;
-
-    if (!should_hard_suppress) {
-      if (next_candidate.score == original_score) {
-        // Suppression has not occurred, so select next_candidate.
-        selected_indices[*num_selected_indices] = next_candidate.index;
-        if (selected_scores) {
-          selected_scores[*num_selected_indices] = next_candidate.score;
+
+    size_t selected = 0;
+    for (size_t ix = 0; ix < candidates; ix++) {
+        const int candidate = scratch->order[ix];
+        const float *box = boxes + (candidate * 4);
+        const int candidate_class = classes[candidate];
+        const float ymin = std::min<float>(box[0], box[2]);
+        const float ymax = std::max<float>(box[0], box[2]);
+        const float xmin = std::min<float>(box[1], box[3]);
+        const float xmax = std::max<float>(box[1], box[3]);
+        const float area = (ymax - ymin) * (xmax - xmin);
+
+        // no early exit, so the compiler can vectorize this loop
+        int suppressed = 0;
+        for (size_t j = 0; j < selected; j++) {
+            const float inter_h = std::max<float>(std::min<float>(ymax, scratch->selected_ymax[j]) - std::max<float>(ymin, scratch->selected_ymin[j]), 0.0f);
+            const float inter_w = std::max<float>(std::min<float>(xmax, scratch->selected_xmax[j]) - std::max<float>(xmin, scratch->selected_xmin[j]), 0.0f);
+            const float intersection = inter_h * inter_w;
+            const float iou = (area <= 0 || scratch->selected_area[j] <= 0) ?
+                0.0f :
+                intersection / (area + scratch->selected_area[j] - intersection);
+            const int same_class = !class_aware || scratch->selected_classes[j] == candidate_class;
+
+            suppressed |= same_class & (iou >= iou_threshold);
+        }
+
+        if (suppressed) {
+            continue;
         }
-        ++*num_selected_indices;
-      }
-      if ((soft_nms_sigma > 0.0) && (next_candidate.score > score_threshold)) {
-        // Soft suppression might have occurred and current score is still
-        // greater than score_threshold; add next_candidate back onto priority
-        // queue.
-        candidate_priority_queue.push(next_candidate);
-      }
+
+        scratch->selected[selected] = candidate;
+        scratch->selected_classes[selected] = candidate_class;
+        scratch->selected_ymin[selected] = ymin;
+        scratch->selected_xmin[selected] = xmin;
+        scratch->selected_ymax[selected] = ymax;
+        scratch->selected_xmax[selected] = xmax;
+        scratch->selected_area[selected] = area;
+        selected++;
     }
-  }
+
+    *selected_count = selected;
+
+    return EI_IMPULSE_OK;
 }
 
 /**
- * Run non-max suppression over the results array (for bounding boxes)
+ * Run non-max suppression over candidate boxes, selections are written to `results`
+ * (which must have room for at least `bb_count` boxes).
+ * `scratch` has room for `scratch_capacity` candidates (EI_NMS_SELECT_BYTES_PER_CANDIDATE each),
+ * larger sets or calls without scratch use the heap
  */
 EI_IMPULSE_ERROR ei_run_nms(
     const ei_impulse_t *impulse,
-    std::vector<ei_impulse_result_bounding_box_t> *results,
+    ei_impulse_result_bounding_box_t *results,
+    size_t *results_count,
     float *boxes,
     float *scores,
     int *classes,
     size_t bb_count,
     bool clip_boxes,
-    bool debug) {
+    bool debug,
+    bool class_aware = EI_CLASSIFIER_NMS_CLASS_AWARE,
+    uint8_t *scratch_memory = NULL,
+    size_t scratch_capacity = 0) {
 
     if (bb_count < 1) {
+        *results_count = 0;
         return EI_IMPULSE_OK;
     }
 
-    int *selected_indices = (int*)ei_malloc(1 * bb_count * sizeof(int));
-    float *selected_scores = (float*)ei_malloc(1 * bb_count * sizeof(float));
-
-    if (!scores || !boxes || !selected_indices || !selected_scores || !classes) {
-        ei_free(selected_indices);
-        ei_free(selected_scores);
+    if (!scores || !boxes || !classes) {
         return EI_IMPULSE_OUT_OF_MEMORY;
     }
 
-    //  boxes: box encodings in format [y1, x1, y2, x2], shape: [num_boxes, 4]
-    //  num_boxes: number of candidates
-    //  scores: scores for candidate boxes, in the same order. shape: [num_boxes]
-    //  max_output_size: the maximum number of selections.
-    //  iou_threshold: Intersection-over-Union (IoU) threshold for NMS
-    //  score_threshold: All candidate scores below this value are rejected
-    //  soft_nms_sigma: Soft NMS parameter, used for decaying scores
-
-    int num_selected_indices;
-
-    NonMaxSuppression(
-        (const float*)boxes, // boxes
-        bb_count, // num_boxes
-        (const float*)scores, // scores
-        bb_count, // max_output_size
-        impulse->object_detection_nms.iou_threshold, // iou_threshold
-        impulse->object_detection_nms.confidence_threshold, // score_threshold
-        0.0f, // soft_nms_sigma
-        selected_indices,
-        selected_scores,
-        &num_selected_indices);
-
-    std::vector<ei_impulse_result_bounding_box_t> new_results;
-
-    for (size_t ix = 0; ix < (size_t)num_selected_indices; ix++) {
-
-        int out_ix = selected_indices[ix];
+    uint8_t *heap_scratch = NULL;
+    ei_nms_scratch_t scratch;
+
+    if (scratch_memory && bb_count <= scratch_capacity) {
+        ei_nms_scratch_init(&scratch, scratch_memory, scratch_capacity);
+    }
+    else {
+        heap_scratch = (uint8_t*)ei_malloc(bb_count * EI_NMS_SELECT_BYTES_PER_CANDIDATE);
+        if (!heap_scratch) {
+            return EI_IMPULSE_OUT_OF_MEMORY;
+        }
+        ei_nms_scratch_init(&scratch, heap_scratch, bb_count);
+    }
+
+    size_t num_selected = 0;
+
+    EI_IMPULSE_ERROR nms_res = ei_nms_select(
+        boxes,
+        scores,
+        classes,
+        bb_count,
+        impulse->object_detection_nms.iou_threshold,
+        impulse->object_detection_nms.confidence_threshold,
+        class_aware,
+        &scratch,
+        &num_selected);
+
+    if (nms_res != EI_IMPULSE_OK) {
+        ei_free(heap_scratch);
+        return nms_res;
+    }
+
+    // boxes / classes are copies, so results can be overwritten in place
+    for (size_t ix = 0; ix < num_selected; ix++) {
+
+        int out_ix = scratch.selected[ix];
         ei_impulse_result_bounding_box_t bb;
         bb.label  = impulse->categories[classes[out_ix]];
-        bb.value  = selected_scores[ix];
+        bb.value  = scores[out_ix];
 
         float ymin = boxes[(out_ix * 4) + 0];
         float xmin = boxes[(out_ix * 4) + 1];
@@ -273,7 +231,7 @@ EI_IMPULSE_ERROR ei_run_nms(
         bb.x      = static_cast<uint32_t>(xmin);
         bb.height = static_cast<uint32_t>(ymax) - bb.y;
         bb.width  = static_cast<uint32_t>(xmax) - bb.x;
-        new_results.push_back(bb);
+        results[ix] = bb;
 
         if (debug) {
           ei_printf("Found bb with label %s\n", bb.label);
@@ -281,14 +239,9 @@ EI_IMPULSE_ERROR ei_run_nms(
 
     }
 
-    results->clear();
+    *results_count = num_selected;
 
-    for (size_t ix = 0; ix < new_results.size(); ix++) {
-        results->push_back(new_results[ix]);
-    }
-
-    ei_free(selected_indices);
-    ei_free(selected_scores);
+    ei_free(heap_scratch);
 
     return EI_IMPULSE_OK;
 
@@ -300,13 +253,51 @@ EI_IMPULSE_ERROR ei_run_nms(
 EI_IMPULSE_ERROR ei_run_nms(
     const ei_impulse_t *impulse,
     std::vector<ei_impulse_result_bounding_box_t> *results,
+    float *boxes,
+    float *scores,
+    int *classes,
+    size_t bb_count,
     bool clip_boxes,
     bool debug) {
 
+    if (bb_count < 1) {
+        return EI_IMPULSE_OK;
+    }
+
+    size_t results_count = 0;
+
+    results->resize(bb_count);
+
+    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse, results->data(), &results_count,
+                                          boxes, scores,
+                                          classes, bb_count,
+                                          clip_boxes,
+                                          debug);
+
+    results->resize(nms_res == EI_IMPULSE_OK ? results_count : 0);
+
+    return nms_res;
+}
+
+/**
+ * Run non-max suppression in place over a fixed array of bounding boxes,
+ * `results_count` is updated with the number of selections.
+ * `scratch` has room for `scratch_capacity` candidates (EI_NMS_SCRATCH_BYTES_PER_CANDIDATE each)
+ * and is owned by the caller, larger sets or calls without scratch use the heap
+ */
+EI_IMPULSE_ERROR ei_run_nms(
+    const ei_impulse_t *impulse,
+    ei_impulse_result_bounding_box_t *results,
+    size_t *results_count,
+    bool clip_boxes,
+    bool debug,
+    bool class_aware = EI_CLASSIFIER_NMS_CLASS_AWARE,
+    uint8_t *scratch_memory = NULL,
+    size_t scratch_capacity = 0) {
+
     size_t bb_count = 0;
-    for (size_t ix = 0; ix < results->size(); ix++) {
-        auto bb = results->at(ix);
-        if (bb.value == 0) {
+    for (size_t ix = 0; ix < *results_count; ix++) {
+        if (results[ix].value == 0) {
             continue;
         }
         bb_count++;
@@ -316,20 +307,25 @@ EI_IMPULSE_ERROR ei_run_nms(
         return EI_IMPULSE_OK;
     }
 
-    float *boxes = (float*)ei_malloc(4 * bb_count * sizeof(float));
-    float *scores = (float*)ei_malloc(1 * bb_count * sizeof(float));
-    int *classes = (int*) ei_malloc(bb_count * sizeof(int));
+    const bool use_heap = !scratch_memory || bb_count > scratch_capacity;
+
+    // candidates first, the selection scratch follows them
+    float *boxes = use_heap ? (float*)ei_malloc(4 * bb_count * sizeof(float)) : (float*)scratch_memory;
+    float *scores = use_heap ? (float*)ei_malloc(1 * bb_count * sizeof(float)) : boxes + (4 * scratch_capacity);
+    int *classes = use_heap ? (int*) ei_malloc(bb_count * sizeof(int)) : (int*)(scores + scratch_capacity);
 
     if (!scores || !boxes || !classes) {
-        ei_free(boxes);
-        ei_free(scores);
-        ei_free(classes);
+        if (use_heap) {
+            ei_free(boxes);
+            ei_free(scores);
+            ei_free(classes);
+        }
         return EI_IMPULSE_OUT_OF_MEMORY;
     }
 
     size_t box_ix = 0;
-    for (size_t ix = 0; ix < results->size(); ix++) {
-        auto bb = results->at(ix);
+    for (size_t ix = 0; ix < *results_count; ix++) {
+        const ei_impulse_result_bounding_box_t &bb = results[ix];
         if (bb.value == 0) {
             continue;
         }
@@ -347,21 +343,46 @@ EI_IMPULSE_ERROR ei_run_nms(
         box_ix++;
     }
 
-    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse, results,
+    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse, results, results_count,
                                           boxes, scores,
                                           classes, bb_count,
                                           clip_boxes,
-                                          debug);
-
+                                          debug,
+                                          class_aware,
+                                          use_heap ? NULL : (uint8_t*)(classes + scratch_capacity),
+                                          use_heap ? 0 : scratch_capacity);
 
-    ei_free(boxes);
-    ei_free(scores);
-    ei_free(classes);
+    if (use_heap) {
+        ei_free(boxes);
+        ei_free(scores);
+        ei_free(classes);
+    }
 
     return nms_res;
 
 }
 
+/**
+ * Run non-max suppression over the results array (for bounding boxes)
+ */
+EI_IMPULSE_ERROR ei_run_nms(
+    const ei_impulse_t *impulse,
+    std::vector<ei_impulse_result_bounding_box_t> *results,
+    bool clip_boxes,
+    bool debug) {
+
+    size_t results_count = results->size();
+
+    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse, results->data(), &results_count, clip_boxes, debug);
+    if (nms_res != EI_IMPULSE_OK) {
+        return nms_res;
+    }
+
+    results->resize(results_count);
+
+    return EI_IMPULSE_OK;
+}
+
 /**
  * Run non-max suppression over the results array (for bounding boxes)
  */
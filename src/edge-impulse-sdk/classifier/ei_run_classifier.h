@@ -73,7 +73,7 @@ namespace {
 
 /* Function prototypes ----------------------------------------------------- */
 extern "C" EI_IMPULSE_ERROR run_inference(ei_impulse_handle_t *handle, ei_feature_t *fmatrix, ei_impulse_result_t *result, bool debug);
-extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(const ei_impulse_t *impulse, signal_t *signal, ei_impulse_result_t *result, bool debug);
+extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(ei_impulse_handle_t *handle, signal_t *signal, ei_impulse_result_t *result, bool debug);
 static EI_IMPULSE_ERROR can_run_classifier_image_quantized(const ei_impulse_t *impulse, ei_learning_block_t block_ptr);
 
 #if EI_CLASSIFIER_LOAD_IMAGE_SCALING
@@ -91,6 +91,21 @@ static RecognizeEvents *avg_scores = NULL;
 /* These functions (up to Public functions section) are not exposed to end-user,
 therefore changes are allowed. */
 
+/**
+ * @brief      Arms the deadline of a handle for the duration of a run, so the
+ *             cancellation points abort it with EI_IMPULSE_CANCELED when late
+ */
+class ei_impulse_deadline_scope_t {
+public:
+    ei_impulse_deadline_scope_t(const ei_impulse_handle_t *handle) {
+        ei_run_impulse_set_deadline(handle->state.deadline_us > 0 ? ei_read_timer_us() + handle->state.deadline_us : 0);
+    }
+
+    ~ei_impulse_deadline_scope_t() {
+        ei_run_impulse_set_deadline(0);
+    }
+};
+
 
 /**
  * @brief      Display the results of the inference
@@ -187,8 +202,11 @@ extern "C" EI_IMPULSE_ERROR run_inference(
 #endif
 
         result->copy_output = block.keep_output;
+#ifdef EI_CLASSIFIER_YOLOV5_MAX_BOXES
+        result->yolov5_nms_scratch = handle->state.get_nms_scratch();
+#endif
 
-        EI_IMPULSE_ERROR res = block.infer_fn(impulse, fmatrix, ix, (uint32_t*)block.input_block_ids, block.input_block_ids_size, result, block.config, debug);
+        EI_IMPULSE_ERROR res = block.infer_fn(handle, fmatrix, ix, (uint32_t*)block.input_block_ids, block.input_block_ids_size, result, block.config, debug);
         if (res != EI_IMPULSE_OK) {
             return res;
         }
@@ -202,7 +220,7 @@ extern "C" EI_IMPULSE_ERROR run_inference(
 #endif
     }
 
-    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+    if (ei_run_impulse_check_deadline() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
     }
 
@@ -229,24 +247,25 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
         return EI_IMPULSE_INFERENCE_ERROR;
     }
 
-#if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL)) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI
+    ei_impulse_deadline_scope_t deadline(handle);
+
+#if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL)) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI || EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8 == 1
     // Shortcut for quantized image models
     ei_learning_block_t block = handle->impulse->learning_blocks[0];
     if (can_run_classifier_image_quantized(handle->impulse, block) == EI_IMPULSE_OK) {
-        return run_classifier_image_quantized(handle->impulse, signal, result, debug);
+        return run_classifier_image_quantized(handle, signal, result, debug);
     }
 #endif
 
     memset(result, 0, sizeof(ei_impulse_result_t));
     uint32_t block_num = handle->impulse->dsp_blocks_size + handle->impulse->learning_blocks_size;
 
-    // smart pointer to features array
-    std::unique_ptr<ei_feature_t[]> features_ptr(new ei_feature_t[block_num]);
-    ei_feature_t* features = features_ptr.get();
-    memset(features, 0, sizeof(ei_feature_t) * block_num);
-
-    // have it outside of the loop to avoid going out of scope
-    std::unique_ptr<ei::matrix_t> *matrix_ptrs = new std::unique_ptr<ei::matrix_t>[block_num];
+    // feature matrices are views into an arena owned by the handle
+    ei_feature_t* features = handle->state.get_features(EI_CLASSIFIER_SINGLE_FEATURE_INPUT == 0);
+    if (!features) {
+        ei_printf("ERR: Failed to allocate feature arena\n");
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
 
     uint64_t dsp_start_us = ei_read_timer_us();
 
@@ -254,20 +273,15 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
 
     for (size_t ix = 0; ix < handle->impulse->dsp_blocks_size; ix++) {
         ei_model_dsp_t block = handle->impulse->dsp_blocks[ix];
-        matrix_ptrs[ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.n_output_features));
-        features[ix].matrix = matrix_ptrs[ix].get();
-        features[ix].blockId = block.blockId;
 
         if (out_features_index + block.n_output_features > handle->impulse->nn_input_frame_size) {
             ei_printf("ERR: Would write outside feature buffer\n");
-            delete[] matrix_ptrs;
             return EI_IMPULSE_DSP_ERROR;
         }
 
 #if EIDSP_SIGNAL_C_FN_POINTER
         if (block.axes_size != handle->impulse->raw_samples_per_frame) {
             ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
-            delete[] matrix_ptrs;
             return EI_IMPULSE_DSP_ERROR;
         }
         auto internal_signal = signal;
@@ -298,30 +312,16 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
 
         if (ret != EIDSP_OK) {
             ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
-            delete[] matrix_ptrs;
             return EI_IMPULSE_DSP_ERROR;
         }
 
-        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
-            delete[] matrix_ptrs;
+        if (ei_run_impulse_check_deadline() == EI_IMPULSE_CANCELED) {
             return EI_IMPULSE_CANCELED;
         }
 
         out_features_index += block.n_output_features;
     }
 
-#if EI_CLASSIFIER_SINGLE_FEATURE_INPUT == 0
-    for (size_t ix = 0; ix < handle->impulse->learning_blocks_size; ix++) {
-        ei_learning_block_t block = handle->impulse->learning_blocks[ix];
-
-        if (block.keep_output) {
-            matrix_ptrs[handle->impulse->dsp_blocks_size + ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.output_features_count));
-            features[handle->impulse->dsp_blocks_size + ix].matrix = matrix_ptrs[handle->impulse->dsp_blocks_size + ix].get();
-            features[handle->impulse->dsp_blocks_size + ix].blockId = block.blockId;
-        }
-    }
-#endif // EI_CLASSIFIER_SINGLE_FEATURE_INPUT
-
     result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
@@ -343,9 +343,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
         ei_printf("Running impulse...\n");
     }
 
-    EI_IMPULSE_ERROR res = run_inference(handle, features, result, debug);
-    delete[] matrix_ptrs;
-    return res;
+    return run_inference(handle, features, result, debug);
 }
 
 /**
@@ -379,6 +377,8 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
                                             bool debug,
                                             bool enable_maf)
 {
+    ei_impulse_deadline_scope_t deadline(handle);
+
     auto impulse = handle->impulse;
     static ei::matrix_t static_features_matrix(1, impulse->nn_input_frame_size);
     if (!static_features_matrix.buffer) {
@@ -439,7 +439,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
             return EI_IMPULSE_DSP_ERROR;
         }
 
-        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+        if (ei_run_impulse_check_deadline() == EI_IMPULSE_CANCELED) {
             return EI_IMPULSE_CANCELED;
         }
 
@@ -463,23 +463,17 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
     if (classifier_continuous_features_written >= impulse->nn_input_frame_size) {
         dsp_start_us = ei_read_timer_us();
 
-        uint32_t block_num = impulse->dsp_blocks_size + impulse->learning_blocks_size;
-
-        // smart pointer to features array
-        std::unique_ptr<ei_feature_t[]> features_ptr(new ei_feature_t[block_num]);
-        ei_feature_t* features = features_ptr.get();
-        memset(features, 0, sizeof(ei_feature_t) * block_num);
-
-        // have it outside of the loop to avoid going out of scope
-        std::unique_ptr<ei::matrix_t> *matrix_ptrs = new std::unique_ptr<ei::matrix_t>[block_num];
+        // feature matrices are views into an arena owned by the handle
+        ei_feature_t* features = handle->state.get_features(false);
+        if (!features) {
+            ei_printf("ERR: Failed to allocate feature arena\n");
+            return EI_IMPULSE_OUT_OF_MEMORY;
+        }
 
         out_features_index = 0;
         // iterate over every dsp block and run normalization
         for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
             ei_model_dsp_t block = impulse->dsp_blocks[ix];
-            matrix_ptrs[ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.n_output_features));
-            features[ix].matrix = matrix_ptrs[ix].get();
-            features[ix].blockId = block.blockId;
 
             /* Create a copy of the matrix for normalization */
             for (size_t m_ix = 0; m_ix < block.n_output_features; m_ix++) {
@@ -549,7 +543,6 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
             }
         }
 #endif
-        delete[] matrix_ptrs;
     }
     else {
         for (int i = 0; i < impulse->label_count; i++) {
@@ -584,11 +577,18 @@ __attribute__((unused)) static EI_IMPULSE_ERROR can_run_classifier_image_quantiz
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
 
-    // Check if we have a quantized NN Input layer (input is always quantized for DRP-AI)
+    // Check if we have a quantized NN Input layer (input is always quantized for DRP-AI,
+    // compiled models with a uint8 input tensor quantize their input as well)
     ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)block_ptr.config;
+#if EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8 == 1
+    if (block_config->quantized != 1 && block_config->compiled != 1) {
+        return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
+    }
+#else
     if (block_config->quantized != 1) {
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
+#endif
 
     // And if we have one DSP block which operates on images...
     if (impulse->dsp_blocks_size != 1 || impulse->dsp_blocks[0].extract_fn != extract_image_features) {
@@ -598,7 +598,7 @@ __attribute__((unused)) static EI_IMPULSE_ERROR can_run_classifier_image_quantiz
     return EI_IMPULSE_OK;
 }
 
-#if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL)
+#if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL)) || EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8 == 1
 
 /**
  * Special function to run the classifier on images, only works on TFLite models (either interpreter, EON, tensaiflow, drpai, tidl, memryx)
@@ -606,17 +606,17 @@ __attribute__((unused)) static EI_IMPULSE_ERROR can_run_classifier_image_quantiz
  * returns EI_IMPULSE_OK.
  */
 extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     signal_t *signal,
     ei_impulse_result_t *result,
     bool debug = false)
 {
     memset(result, 0, sizeof(ei_impulse_result_t));
 
-    return run_nn_inference_image_quantized(impulse, signal, result, impulse->learning_blocks[0].config, debug);
+    return run_nn_inference_image_quantized(handle, signal, result, handle->impulse->learning_blocks[0].config, debug);
 }
 
-#endif // #if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI)
+#endif // #if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI)) || EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8 == 1
 
 /* Public functions ------------------------------------------------------- */
 
@@ -794,6 +794,61 @@ extern "C" void run_classifier_deinit(void)
     }
 }
 
+/**
+ * @brief      Keep the learning blocks resident between inferences: the model graph
+ *             is initialized once (on the next inference) and its arena and tensor
+ *             bindings stay alive until run_classifier_resident_deinit() is called.
+ */
+extern "C" void run_classifier_resident_init()
+{
+    ei_default_impulse.state.is_resident = true;
+}
+
+/**
+ * @brief      Keep the learning blocks resident between inferences, for multi-model support
+ */
+__attribute__((unused)) void run_classifier_resident_init(ei_impulse_handle_t *handle)
+{
+    handle->state.is_resident = true;
+}
+
+/**
+ * @brief      Tear down the resident learning blocks and go back to setting up
+ *             the model on every inference
+ */
+extern "C" void run_classifier_resident_deinit()
+{
+    ei_default_impulse.state.reset_learning_blocks();
+    ei_default_impulse.state.is_resident = false;
+}
+
+/**
+ * @brief      Tear down the resident learning blocks, for multi-model support
+ */
+__attribute__((unused)) void run_classifier_resident_deinit(ei_impulse_handle_t *handle)
+{
+    handle->state.reset_learning_blocks();
+    handle->state.is_resident = false;
+}
+
+/**
+ * @brief      Abort inferences that run longer than budget_us with EI_IMPULSE_CANCELED,
+ *             so a late frame can be dropped for a fresh one. The budget is checked
+ *             between DSP blocks, between operators and before NMS (0 = no deadline)
+ */
+extern "C" void run_classifier_set_deadline(uint32_t budget_us)
+{
+    ei_default_impulse.state.deadline_us = budget_us;
+}
+
+/**
+ * @brief      Set the inference budget, for multi-model support
+ */
+__attribute__((unused)) void run_classifier_set_deadline(ei_impulse_handle_t *handle, uint32_t budget_us)
+{
+    handle->state.deadline_us = budget_us;
+}
+
 /**
  * @brief      Fill the complete matrix with sample slices. From there, run inference
  *             on the matrix.
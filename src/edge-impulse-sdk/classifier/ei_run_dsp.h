@@ -25,6 +25,15 @@
 #include "edge-impulse-sdk/dsp/ei_flatten.h"
 #include "model-parameters/model_metadata.h"
 
+// EON models with a uint8 input tensor can take quantized image features directly,
+// even when the model itself is not flagged as quantized
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1) && \
+    defined(EI_CLASSIFIER_TFLITE_INPUT_DATATYPE) && (EI_CLASSIFIER_TFLITE_INPUT_DATATYPE == EI_CLASSIFIER_DATATYPE_UINT8)
+#define EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8     1
+#else
+#define EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8     0
+#endif
+
 #if EI_CLASSIFIER_HR_ENABLED
 #include "edge-impulse-sdk/dsp/ei_hr.hpp"
 #endif
@@ -1336,6 +1345,151 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
 }
 #endif // (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1) && (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_DRPAI)
 
+#if EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8 == 1
+
+/**
+ * Scale one 0..255 channel value the way ei_scale_fmatrix does for the float path.
+ * cx is the index of the channel in the model input, which is B, G, R for
+ * EI_CLASSIFIER_IMAGE_SCALING_BGR_SUBTRACT_IMAGENET_MEAN and R, G, B otherwise.
+ */
+static inline float image_scale_channel_value(float v, size_t cx, int image_scaling) {
+    static const float torch_mean[] = { 0.485, 0.456, 0.406 };
+    static const float torch_std[] = { 0.229, 0.224, 0.225 };
+    // This is ordered BGR
+    static const float tao_mean[] = { 103.939, 116.779, 123.68 };
+
+    switch (image_scaling) {
+        case EI_CLASSIFIER_IMAGE_SCALING_TORCH:
+            return ((v / 255.0f) - torch_mean[cx]) / torch_std[cx];
+        case EI_CLASSIFIER_IMAGE_SCALING_0_255:
+            return v;
+        case EI_CLASSIFIER_IMAGE_SCALING_MIN128_127:
+            return v - 128.0f;
+        case EI_CLASSIFIER_IMAGE_SCALING_MIN1_1:
+            return ((v / 255.0f) * 2.0f) - 1.0f;
+        case EI_CLASSIFIER_IMAGE_SCALING_BGR_SUBTRACT_IMAGENET_MEAN:
+            return v - tao_mean[cx];
+        default:
+            return v / 255.0f;
+    }
+}
+
+/**
+ * Extract image features straight into a uint8 input tensor. Every channel value is
+ * mapped through a 256-entry table built from the tensor quantization parameters,
+ * so no float feature matrix is needed. The table is kept in lut between runs and
+ * only rebuilt when the parameters change; lut may be NULL.
+ */
+__attribute__((unused)) int extract_image_features_quantized(signal_t *signal, matrix_u8_t *output_matrix, void *config_ptr, float scale, float zero_point, const float frequency,
+                                                             int image_scaling, ei_image_quantize_lut_t *lut) {
+    ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
+
+    if (image_scaling < EI_CLASSIFIER_IMAGE_SCALING_NONE ||
+        image_scaling > EI_CLASSIFIER_IMAGE_SCALING_BGR_SUBTRACT_IMAGENET_MEAN) {
+        EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+    }
+
+    int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
+
+    size_t output_ix = 0;
+
+    const int32_t iRedToGray = (int32_t)(0.299f * 65536.0f);
+    const int32_t iGreenToGray = (int32_t)(0.587f * 65536.0f);
+    const int32_t iBlueToGray = (int32_t)(0.114f * 65536.0f);
+
+    const bool bgr = image_scaling == EI_CLASSIFIER_IMAGE_SCALING_BGR_SUBTRACT_IMAGENET_MEAN;
+    // torch and BGR scaling differ per channel, so grayscale can't go through the table
+    const bool per_channel = image_scaling == EI_CLASSIFIER_IMAGE_SCALING_TORCH || bgr;
+
+    ei_image_quantize_lut_t local_lut;
+    if (!lut) {
+        lut = &local_lut;
+        lut->image_scaling = -1;
+    }
+
+    if (lut->scale != scale || lut->zero_point != zero_point || lut->image_scaling != image_scaling) {
+        for (size_t cx = 0; cx < 3; cx++) {
+            for (size_t vx = 0; vx < 256; vx++) {
+                float v = image_scale_channel_value(static_cast<float>(vx), cx, image_scaling);
+
+                int32_t q = static_cast<int32_t>(round(v / scale) + zero_point);
+                if (q < 0) q = 0;
+                else if (q > 255) q = 255;
+                lut->values[cx][vx] = static_cast<uint8_t>(q);
+            }
+        }
+        lut->scale = scale;
+        lut->zero_point = zero_point;
+        lut->image_scaling = image_scaling;
+    }
+    const uint8_t (*quantize_lut)[256] = lut->values;
+
+#if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
+    const size_t page_size = EI_DSP_IMAGE_BUFFER_STATIC_SIZE;
+#else
+    const size_t page_size = 1024;
+#endif
+
+    // buffered read from the signal
+    size_t bytes_left = signal->total_length;
+    for (size_t ix = 0; ix < signal->total_length; ix += page_size) {
+        size_t elements_to_read = bytes_left > page_size ? page_size : bytes_left;
+
+#if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
+        matrix_t input_matrix(elements_to_read, config.axes, ei_dsp_image_buffer);
+#else
+        matrix_t input_matrix(elements_to_read, config.axes);
+#endif
+        if (!input_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        signal->get_data(ix, elements_to_read, input_matrix.buffer);
+
+        for (size_t jx = 0; jx < elements_to_read; jx++) {
+            uint32_t pixel = static_cast<uint32_t>(input_matrix.buffer[jx]);
+
+            uint8_t r = static_cast<uint8_t>(pixel >> 16 & 0xff);
+            uint8_t g = static_cast<uint8_t>(pixel >> 8 & 0xff);
+            uint8_t b = static_cast<uint8_t>(pixel & 0xff);
+
+            if (channel_count == 3 && bgr) {
+                output_matrix->buffer[output_ix++] = quantize_lut[0][b];
+                output_matrix->buffer[output_ix++] = quantize_lut[1][g];
+                output_matrix->buffer[output_ix++] = quantize_lut[2][r];
+            }
+            else if (channel_count == 3) {
+                output_matrix->buffer[output_ix++] = quantize_lut[0][r];
+                output_matrix->buffer[output_ix++] = quantize_lut[1][g];
+                output_matrix->buffer[output_ix++] = quantize_lut[2][b];
+            }
+            else if (!per_channel) {
+                // ITU-R 601-2 luma transform, the scaling is the same for every channel
+                int32_t gray = (iRedToGray * r) + (iGreenToGray * g) + (iBlueToGray * b);
+                gray >>= 16;
+                output_matrix->buffer[output_ix++] = quantize_lut[0][gray];
+            }
+            else {
+                // per channel scaling is applied before the luma transform
+                float fr = image_scale_channel_value(r, bgr ? 2 : 0, image_scaling);
+                float fg = image_scale_channel_value(g, 1, image_scaling);
+                float fb = image_scale_channel_value(b, bgr ? 0 : 2, image_scaling);
+
+                float v = (0.299f * fr) + (0.587f * fg) + (0.114f * fb);
+                int32_t q = static_cast<int32_t>(round(v / scale) + zero_point);
+                if (q < 0) q = 0;
+                else if (q > 255) q = 255;
+                output_matrix->buffer[output_ix++] = static_cast<uint8_t>(q);
+            }
+        }
+
+        bytes_left -= elements_to_read;
+    }
+
+    return EIDSP_OK;
+}
+
+#endif // EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8 == 1
+
 /**
  * Clear all state regarding continuous audio. Invoke this function after continuous audio loop ends.
  */
@@ -21,7 +21,7 @@
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 
 EI_IMPULSE_ERROR run_kmeans_anomaly(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     ei_feature_t *fmatrix,
     uint32_t learn_block_index,
     uint32_t* input_block_ids,
@@ -31,7 +31,7 @@ EI_IMPULSE_ERROR run_kmeans_anomaly(
     bool debug);
 
 EI_IMPULSE_ERROR run_gmm_anomaly(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     ei_feature_t *fmatrix,
     uint32_t learn_block_index,
     uint32_t* input_block_ids,
@@ -41,7 +41,7 @@ EI_IMPULSE_ERROR run_gmm_anomaly(
     bool debug);
 
 EI_IMPULSE_ERROR run_nn_inference(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     ei_feature_t *fmatrix,
     uint32_t learn_block_index,
     uint32_t* input_block_ids,
@@ -477,7 +477,7 @@ static EI_IMPULSE_ERROR inference_onnx_run(const ei_impulse_t *impulse,
  * @return     The ei impulse error.
  */
 EI_IMPULSE_ERROR run_nn_inference(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     ei_feature_t *afmatrix,
     uint32_t learn_block_index,
     uint32_t* input_block_ids,
@@ -486,6 +486,7 @@ EI_IMPULSE_ERROR run_nn_inference(
     void *config_ptr,
     bool debug = false)
 {
+    const ei_impulse_t *impulse = handle->impulse;
     static std::vector<Ort::Value> input_tensors;
     static std::vector<Ort::Value> output_tensors;
     static Ort::Session* session;
@@ -576,12 +577,13 @@ EI_IMPULSE_ERROR run_nn_inference(
  * returns EI_IMPULSE_OK.
  */
 EI_IMPULSE_ERROR run_nn_inference_image_quantized(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     signal_t *signal,
     ei_impulse_result_t *result,
     void *config_ptr,
     bool debug = false)
 {
+    const ei_impulse_t *impulse = handle->impulse;
     static std::vector<Ort::Value> input_tensors;
     static std::vector<Ort::Value> output_tensors;
     static Ort::Session* session;
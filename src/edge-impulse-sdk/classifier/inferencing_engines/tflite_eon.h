@@ -22,6 +22,7 @@
 
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_op_profiler.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/classifier/ei_fill_result_struct.h"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
@@ -82,6 +83,81 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * Graph context of a resident learning block. The compiled graph keeps its arena
+ * between inferences, so the tensor bindings only need to be resolved once.
+ */
+typedef struct {
+    ei_config_tflite_eon_graph_t *graph_config;
+    TfLiteTensor input;
+    TfLiteTensor output;
+    TfLiteTensor output_labels;
+    TfLiteTensor output_scores;
+} ei_tflite_eon_resident_t;
+
+static void inference_tflite_resident_free(void *ctx)
+{
+    ei_tflite_eon_resident_t *resident = (ei_tflite_eon_resident_t*)ctx;
+    resident->graph_config->model_reset(ei_aligned_free);
+    ei_free(resident);
+}
+
+/**
+ * Get the resident context of a learning block, initializing the graph on first use.
+ * Note that an EON graph is a single instance, only one handle can keep it resident.
+ *
+ * @param   handle              Impulse handle owning the context
+ * @param   learn_block_index   Index of the learning block
+ * @param   resident            Pointer to the resident context
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_resident_get(
+    ei_impulse_handle_t *handle,
+    uint32_t learn_block_index,
+    ei_learning_block_config_tflite_graph_t *block_config,
+    ei_tflite_eon_resident_t **resident) {
+
+    ei_learning_block_state_t *block_state = &handle->state.learning_block_states[learn_block_index];
+
+    if (block_state->ctx != nullptr) {
+        *resident = (ei_tflite_eon_resident_t*)block_state->ctx;
+        return EI_IMPULSE_OK;
+    }
+
+    ei_tflite_eon_resident_t *ctx = (ei_tflite_eon_resident_t*)ei_calloc(1, sizeof(ei_tflite_eon_resident_t));
+    if (ctx == nullptr) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+    ctx->graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
+
+    uint64_t ctx_start_us;
+    ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
+
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+        block_config,
+        &ctx_start_us,
+        &ctx->input,
+        &ctx->output,
+        &ctx->output_labels,
+        &ctx->output_scores,
+        p_tensor_arena);
+
+    if (init_res != EI_IMPULSE_OK) {
+        if (init_res != EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED) {
+            ctx->graph_config->model_reset(ei_aligned_free);
+        }
+        ei_free(ctx);
+        return init_res;
+    }
+
+    block_state->ctx = ctx;
+    block_state->free_fn = inference_tflite_resident_free;
+    *resident = ctx;
+
+    return EI_IMPULSE_OK;
+}
+
 /**
  * Run TFLite model
  *
@@ -107,12 +183,26 @@ static EI_IMPULSE_ERROR inference_tflite_run(
 
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
-    if (graph_config->model_invoke() != kTfLiteOk) {
+    uint64_t invoke_start_us = ei_read_timer_us();
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    // only timed if the compiled graph wraps its layers with ScopedMicroOpProfiler
+    tflite::GetMicroOpProfiler()->BeginInvoke();
+#endif
+
+    // compiled graphs calling ei_run_impulse_check_deadline() between layers
+    // stop early with kTfLiteCancelled
+    TfLiteStatus invoke_status = graph_config->model_invoke();
+    if (invoke_status == kTfLiteCancelled) {
+        return EI_IMPULSE_CANCELED;
+    }
+    if (invoke_status != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
     uint64_t ctx_end_us = ei_read_timer_us();
 
+    result->timing.invoke_us = ctx_end_us - invoke_start_us;
     result->timing.classification_us = ctx_end_us - ctx_start_us;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
 
@@ -124,11 +214,13 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     EI_IMPULSE_ERROR fill_res = fill_result_struct_from_output_tensor_tflite(
         impulse, block_config, output, labels_tensor, scores_tensor, result, debug);
 
+    result->timing.postprocessing_us = ei_read_timer_us() - ctx_end_us;
+
     if (fill_res != EI_IMPULSE_OK) {
         return fill_res;
     }
 
-    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+    if (ei_run_impulse_check_deadline() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
     }
 
@@ -175,8 +267,16 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         return input_res;
     }
 
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    tflite::GetMicroOpProfiler()->BeginInvoke();
+#endif
+
     // invoke the model
-    if (graph_config->model_invoke() != kTfLiteOk) {
+    TfLiteStatus invoke_status = graph_config->model_invoke();
+    if (invoke_status == kTfLiteCancelled) {
+        return EI_IMPULSE_CANCELED;
+    }
+    if (invoke_status != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
@@ -202,7 +302,7 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
  * @return     The ei impulse error.
  */
 EI_IMPULSE_ERROR run_nn_inference(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     ei_feature_t *fmatrix,
     uint32_t learn_block_index,
     uint32_t* input_block_ids,
@@ -211,6 +311,7 @@ EI_IMPULSE_ERROR run_nn_inference(
     void *config_ptr,
     bool debug = false)
 {
+    const ei_impulse_t *impulse = handle->impulse;
     ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
@@ -218,28 +319,45 @@ EI_IMPULSE_ERROR run_nn_inference(
     TfLiteTensor output;
     TfLiteTensor output_scores;
     TfLiteTensor output_labels;
+    ei_tflite_eon_resident_t *resident = nullptr;
 
     uint64_t ctx_start_us = ei_read_timer_us();
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
 
-    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
-        block_config,
-        &ctx_start_us,
-        &input,
-        &output,
-        &output_labels,
-        &output_scores,
-        p_tensor_arena);
-
-    if (init_res != EI_IMPULSE_OK) {
-        return init_res;
+    if (handle->state.is_resident) {
+        EI_IMPULSE_ERROR init_res = inference_tflite_resident_get(handle, learn_block_index, block_config, &resident);
+        if (init_res != EI_IMPULSE_OK) {
+            return init_res;
+        }
     }
+    else {
+        EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+            block_config,
+            &ctx_start_us,
+            &input,
+            &output,
+            &output_labels,
+            &output_scores,
+            p_tensor_arena);
+
+        if (init_res != EI_IMPULSE_OK) {
+            return init_res;
+        }
+    }
+
+    TfLiteTensor *p_input = resident ? &resident->input : &input;
+    TfLiteTensor *p_output = resident ? &resident->output : &output;
+    TfLiteTensor *p_output_labels = resident ? &resident->output_labels : &output_labels;
+    TfLiteTensor *p_output_scores = resident ? &resident->output_scores : &output_scores;
 
     uint8_t* tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
 
     size_t mtx_size = impulse->dsp_blocks_size + impulse->learning_blocks_size;
-    auto input_res = fill_input_tensor_from_matrix(fmatrix, &input, input_block_ids, input_block_ids_size, mtx_size);
+    auto input_res = fill_input_tensor_from_matrix(fmatrix, p_input, input_block_ids, input_block_ids_size, mtx_size);
     if (input_res != EI_IMPULSE_OK) {
+        if (!resident) {
+            graph_config->model_reset(ei_aligned_free);
+        }
         return input_res;
     }
 
@@ -247,19 +365,24 @@ EI_IMPULSE_ERROR run_nn_inference(
         impulse,
         block_config,
         ctx_start_us,
-        &output,
-        &output_labels,
-        &output_scores,
+        p_output,
+        p_output_labels,
+        p_output_scores,
         tensor_arena, result, debug);
 
     if (result->copy_output) {
-        auto output_res = fill_output_matrix_from_tensor(&output, fmatrix[impulse->dsp_blocks_size + learn_block_index].matrix);
+        auto output_res = fill_output_matrix_from_tensor(p_output, fmatrix[impulse->dsp_blocks_size + learn_block_index].matrix);
         if (output_res != EI_IMPULSE_OK) {
+            if (!resident) {
+                graph_config->model_reset(ei_aligned_free);
+            }
             return output_res;
         }
     }
 
-    graph_config->model_reset(ei_aligned_free);
+    if (!resident) {
+        graph_config->model_reset(ei_aligned_free);
+    }
 
     result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
 
@@ -270,19 +393,20 @@ EI_IMPULSE_ERROR run_nn_inference(
     return EI_IMPULSE_OK;
 }
 
-#if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
+#if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1) || (EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8 == 1)
 /**
  * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON or for tensaiflow)
  * that allocates a lot less memory by quantizing in place. This only works if 'can_run_classifier_image_quantized'
  * returns EI_IMPULSE_OK.
  */
 EI_IMPULSE_ERROR run_nn_inference_image_quantized(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     signal_t *signal,
     ei_impulse_result_t *result,
     void *config_ptr,
     bool debug = false) {
 
+    const ei_impulse_t *impulse = handle->impulse;
     ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
@@ -293,40 +417,76 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     TfLiteTensor output;
     TfLiteTensor output_scores;
     TfLiteTensor output_labels;
+    ei_tflite_eon_resident_t *resident = nullptr;
 
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
 
-    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
-        block_config,
-        &ctx_start_us,
-        &input, &output,
-        &output_labels,
-        &output_scores,
-        p_tensor_arena);
-
-    if (init_res != EI_IMPULSE_OK) {
-        return init_res;
+    if (handle->state.is_resident) {
+        EI_IMPULSE_ERROR init_res = inference_tflite_resident_get(handle, 0, block_config, &resident);
+        if (init_res != EI_IMPULSE_OK) {
+            return init_res;
+        }
     }
-
-    if (input.type != TfLiteType::kTfLiteInt8 && input.type != TfLiteType::kTfLiteUInt8) {
-        return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
+    else {
+        EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+            block_config,
+            &ctx_start_us,
+            &input, &output,
+            &output_labels,
+            &output_scores,
+            p_tensor_arena);
+
+        if (init_res != EI_IMPULSE_OK) {
+            return init_res;
+        }
     }
 
-    uint64_t dsp_start_us = ei_read_timer_us();
+    TfLiteTensor *p_input = resident ? &resident->input : &input;
+    TfLiteTensor *p_output = resident ? &resident->output : &output;
+    TfLiteTensor *p_output_labels = resident ? &resident->output_labels : &output_labels;
+    TfLiteTensor *p_output_scores = resident ? &resident->output_scores : &output_scores;
 
-    // features matrix maps around the input tensor to not allocate any memory
-    ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input.data.int8);
+    uint64_t dsp_start_us = ei_read_timer_us();
 
+    // features matrix maps around the input tensor to not allocate any memory,
     // run DSP process and quantize automatically
-    int ret = extract_image_features_quantized(signal, &features_matrix, impulse->dsp_blocks[0].config, input.params.scale, input.params.zero_point,
-        impulse->frequency, impulse->learning_blocks[0].image_scaling);
+    int ret;
+    size_t features_count = impulse->nn_input_frame_size;
+#if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
+    if (p_input->type == TfLiteType::kTfLiteInt8) {
+        ei::matrix_i8_t features_matrix(1, features_count, p_input->data.int8);
+        ret = extract_image_features_quantized(signal, &features_matrix, impulse->dsp_blocks[0].config, p_input->params.scale, p_input->params.zero_point,
+            impulse->frequency, impulse->learning_blocks[0].image_scaling);
+    }
+    else
+#endif
+#if EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8 == 1
+    if (p_input->type == TfLiteType::kTfLiteUInt8) {
+        ei::matrix_u8_t features_matrix(1, features_count, p_input->data.uint8);
+        ret = extract_image_features_quantized(signal, &features_matrix, impulse->dsp_blocks[0].config, p_input->params.scale, p_input->params.zero_point,
+            impulse->frequency, impulse->learning_blocks[0].image_scaling, handle->state.get_image_quantize_lut());
+    }
+    else
+#endif
+    {
+        if (!resident) {
+            graph_config->model_reset(ei_aligned_free);
+        }
+        return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
+    }
 
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+        if (!resident) {
+            graph_config->model_reset(ei_aligned_free);
+        }
         return EI_IMPULSE_DSP_ERROR;
     }
 
-    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+    if (ei_run_impulse_check_deadline() == EI_IMPULSE_CANCELED) {
+        if (!resident) {
+            graph_config->model_reset(ei_aligned_free);
+        }
         return EI_IMPULSE_CANCELED;
     }
 
@@ -335,8 +495,9 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
 
     if (debug) {
         ei_printf("Features (%d ms.): ", result->timing.dsp);
-        for (size_t ix = 0; ix < features_matrix.cols; ix++) {
-            ei_printf_float((features_matrix.buffer[ix] - input.params.zero_point) * input.params.scale);
+        for (size_t ix = 0; ix < features_count; ix++) {
+            int32_t q = p_input->type == TfLiteType::kTfLiteUInt8 ? p_input->data.uint8[ix] : p_input->data.int8[ix];
+            ei_printf_float((q - p_input->params.zero_point) * p_input->params.scale);
             ei_printf(" ");
         }
         ei_printf("\n");
@@ -348,14 +509,16 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         impulse,
         block_config,
         ctx_start_us,
-        &output,
-        &output_labels,
-        &output_scores,
+        p_output,
+        p_output_labels,
+        p_output_scores,
         static_cast<uint8_t*>(p_tensor_arena.get()),
         result,
         debug);
 
-    graph_config->model_reset(ei_aligned_free);
+    if (!resident) {
+        graph_config->model_reset(ei_aligned_free);
+    }
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
@@ -365,7 +528,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
 
     return EI_IMPULSE_OK;
 }
-#endif // EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
+#endif // (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1) || (EI_CLASSIFIER_IMAGE_QUANTIZED_UINT8 == 1)
 
 __attribute__((unused)) int extract_tflite_eon_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
     ei_dsp_config_tflite_eon_t *dsp_config = (ei_dsp_config_tflite_eon_t*)config_ptr;
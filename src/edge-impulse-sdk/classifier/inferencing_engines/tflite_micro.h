@@ -23,8 +23,8 @@
 #include "model-parameters/model_metadata.h"
 
 #include <cmath>
-#include "edge-impulse-sdk/tensorflow/lite/micro/all_ops_resolver.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_interpreter.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_op_profiler.h"
 #include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
 #include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated_full.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
@@ -32,10 +32,19 @@
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
 
+// minimal resolver, see tools/generate_tflite_resolver.py
 #if defined(EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER) && EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER == 1
 #include "tflite-model/tflite-resolver.h"
+#elif defined(__has_include)
+#if __has_include("tflite-model/tflite-resolver.h")
+#include "tflite-model/tflite-resolver.h"
+#endif
 #endif // EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER
 
+#ifndef EI_TFLITE_RESOLVER
+#include "edge-impulse-sdk/tensorflow/lite/micro/all_ops_resolver.h"
+#endif // EI_TFLITE_RESOLVER
+
 #ifdef EI_CLASSIFIER_ALLOCATION_STATIC
 #if defined __GNUC__
 #define ALIGN(X) __attribute__((aligned(X)))
@@ -73,6 +82,7 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
 
 #ifdef EI_CLASSIFIER_ALLOCATION_STATIC
     // Assign a no-op lambda to the "free" function in case of static arena
+    // (shared by all handles, so only one inference can run at a time)
     static uint8_t tensor_arena[EI_CLASSIFIER_TFLITE_ARENA_SIZE] ALIGN(16);
     p_tensor_arena = ei_unique_ptr_t(tensor_arena, [](void*){});
 #else
@@ -85,39 +95,30 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
     p_tensor_arena = ei_unique_ptr_t(tensor_arena, ei_aligned_free);
 #endif
 
-    static bool tflite_first_run = true;
-    static uint8_t *model_arr = NULL;
-
-    if (model_arr != graph_config->model) {
-        tflite_first_run = true;
-        model_arr = (uint8_t*)graph_config->model;
-    }
-
-    static const tflite::Model* model = nullptr;
-
     // ======
     // Initialization code start
     // This part can be run once, but that would require the TFLite arena
-    // to be allocated at all times, which is not ideal (e.g. when doing MFCC)
+    // to be allocated at all times, which is not ideal (e.g. when doing MFCC).
+    // Resident handles do exactly that, see inference_tflite_resident_get()
     // ======
-    if (tflite_first_run) {
-        // Map the model into a usable data structure. This doesn't involve any
-        // copying or parsing, it's a very lightweight operation.
-        model = tflite::GetModel(graph_config->model);
-        if (model->version() != TFLITE_SCHEMA_VERSION) {
-            ei_printf(
-                "Model provided is schema version %d not equal "
-                "to supported version %d.",
-                model->version(), TFLITE_SCHEMA_VERSION);
-            return EI_IMPULSE_TFLITE_ERROR;
-        }
-        tflite_first_run = false;
+
+    // Map the model into a usable data structure. This doesn't involve any
+    // copying or parsing, it's a very lightweight operation (and keeps no
+    // state between calls, so handles can run on several threads)
+    const tflite::Model* model = tflite::GetModel(graph_config->model);
+    if (model->version() != TFLITE_SCHEMA_VERSION) {
+        ei_printf(
+            "Model provided is schema version %d not equal "
+            "to supported version %d.",
+            model->version(), TFLITE_SCHEMA_VERSION);
+        return EI_IMPULSE_TFLITE_ERROR;
     }
 
 #ifdef EI_TFLITE_RESOLVER
     EI_TFLITE_RESOLVER
 #else
-    static tflite::AllOpsResolver resolver; // needs static to match the life of the interpreter
+    // needs static to match the life of the interpreter, read-only once constructed
+    static tflite::AllOpsResolver resolver;
 #endif
 
     // Build an interpreter to run the model with.
@@ -142,10 +143,96 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
         *output_labels = interpreter->output(block_config->output_labels_tensor);
     }
 
-    if (tflite_first_run) {
-        tflite_first_run = false;
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Interpreter context of a resident learning block. The arena, interpreter and
+ * prepared kernel state are kept between inferences, so the memory planner and
+ * the kernels' Prepare only run again when the model changes.
+ */
+typedef struct {
+    const unsigned char *model;
+    uint8_t *tensor_arena;
+    void (*tensor_arena_free)(void*);
+    tflite::MicroInterpreter *interpreter;
+    TfLiteTensor *input;
+    TfLiteTensor *output;
+    TfLiteTensor *output_labels;
+    TfLiteTensor *output_scores;
+} ei_tflite_micro_resident_t;
+
+static void inference_tflite_resident_free(void *ctx)
+{
+    ei_tflite_micro_resident_t *resident = (ei_tflite_micro_resident_t*)ctx;
+    delete resident->interpreter;
+    resident->tensor_arena_free(resident->tensor_arena);
+    ei_free(resident);
+}
+
+/**
+ * Get the resident context of a learning block, building the interpreter on first use
+ * or when the model pointer of the block has changed.
+ *
+ * @param   handle              Impulse handle owning the context
+ * @param   learn_block_index   Index of the learning block
+ * @param   resident            Pointer to the resident context
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_resident_get(
+    ei_impulse_handle_t *handle,
+    uint32_t learn_block_index,
+    ei_learning_block_config_tflite_graph_t *block_config,
+    ei_tflite_micro_resident_t **resident) {
+
+    ei_learning_block_state_t *block_state = &handle->state.learning_block_states[learn_block_index];
+    ei_config_tflite_graph_t *graph_config = (ei_config_tflite_graph_t*)block_config->graph_config;
+
+    if (block_state->ctx != nullptr) {
+        ei_tflite_micro_resident_t *ctx = (ei_tflite_micro_resident_t*)block_state->ctx;
+        if (ctx->model == graph_config->model) {
+            *resident = ctx;
+            return EI_IMPULSE_OK;
+        }
+
+        block_state->free_fn(block_state->ctx);
+        block_state->ctx = nullptr;
+        block_state->free_fn = nullptr;
+    }
+
+    ei_tflite_micro_resident_t *ctx = (ei_tflite_micro_resident_t*)ei_calloc(1, sizeof(ei_tflite_micro_resident_t));
+    if (ctx == nullptr) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    uint64_t ctx_start_us;
+    ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
+
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+        block_config,
+        &ctx_start_us,
+        &ctx->input,
+        &ctx->output,
+        &ctx->output_labels,
+        &ctx->output_scores,
+        &ctx->interpreter,
+        p_tensor_arena);
+
+    if (init_res != EI_IMPULSE_OK) {
+        delete ctx->interpreter;
+        ei_free(ctx);
+        return init_res;
     }
 
+    ctx->model = graph_config->model;
+    ctx->tensor_arena_free = p_tensor_arena.get_deleter();
+    ctx->tensor_arena = static_cast<uint8_t*>(p_tensor_arena.release());
+
+    block_state->ctx = ctx;
+    block_state->free_fn = inference_tflite_resident_free;
+    *resident = ctx;
+
     return EI_IMPULSE_OK;
 }
 
@@ -154,8 +241,8 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
  *
  * @param   ctx_start_us    Start time of the setup function (see above)
  * @param   output          Output tensor
- * @param   interpreter     TFLite interpreter (non-compiled models)
- * @param   tensor_arena    Allocated arena (will be freed)
+ * @param   interpreter     TFLite interpreter (non-compiled models), owned by the caller
+ * @param   tensor_arena    Allocated arena
  * @param   result          Struct for results
  * @param   debug           Whether to print debug info
  *
@@ -173,17 +260,24 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     ei_impulse_result_t *result,
     bool debug) {
 
+    uint64_t invoke_start_us = ei_read_timer_us();
 
     // Run inference, and report any error
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    tflite::GetMicroOpProfiler()->BeginInvoke();
+#endif
     TfLiteStatus invoke_status = interpreter->Invoke();
+    if (invoke_status == kTfLiteCancelled) {
+        return EI_IMPULSE_CANCELED;
+    }
     if (invoke_status != kTfLiteOk) {
-        delete interpreter;
         ei_printf("Invoke failed (%d)\n", invoke_status);
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
     uint64_t ctx_end_us = ei_read_timer_us();
 
+    result->timing.invoke_us = ctx_end_us - invoke_start_us;
     result->timing.classification_us = ctx_end_us - ctx_start_us;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
 
@@ -195,13 +289,11 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     EI_IMPULSE_ERROR fill_res = fill_result_struct_from_output_tensor_tflite(
         impulse, block_config, output, labels_tensor, scores_tensor, result, debug);
 
-    delete interpreter;
-
     if (fill_res != EI_IMPULSE_OK) {
         return fill_res;
     }
 
-    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+    if (ei_run_impulse_check_deadline() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
     }
 
@@ -230,7 +322,7 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
     uint64_t ctx_start_us = ei_read_timer_us();
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
 
-    tflite::MicroInterpreter* interpreter;
+    tflite::MicroInterpreter* interpreter = nullptr;
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(
         config,
         &ctx_start_us,
@@ -239,6 +331,9 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         &output_scores,
         &interpreter, p_tensor_arena);
 
+    ei_unique_ptr_t p_interpreter(interpreter,
+        [](void *ptr) { delete static_cast<tflite::MicroInterpreter*>(ptr); });
+
     if (init_res != EI_IMPULSE_OK) {
         return init_res;
     }
@@ -249,7 +344,13 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
     }
 
     // Run inference, and report any error
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    tflite::GetMicroOpProfiler()->BeginInvoke();
+#endif
     TfLiteStatus invoke_status = interpreter->Invoke();
+    if (invoke_status == kTfLiteCancelled) {
+        return EI_IMPULSE_CANCELED;
+    }
     if (invoke_status != kTfLiteOk) {
         ei_printf("Invoke failed (%d)\n", invoke_status);
         return EI_IMPULSE_TFLITE_ERROR;
@@ -260,8 +361,6 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         return output_res;
     }
 
-    delete interpreter;
-
     return EI_IMPULSE_OK;
 }
 
@@ -275,7 +374,7 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
  * @return     The ei impulse error.
  */
 EI_IMPULSE_ERROR run_nn_inference(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     ei_feature_t *fmatrix,
     uint32_t learn_block_index,
     uint32_t* input_block_ids,
@@ -284,6 +383,7 @@ EI_IMPULSE_ERROR run_nn_inference(
     void *config_ptr,
     bool debug = false)
 {
+    const ei_impulse_t *impulse = handle->impulse;
     ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
 
     TfLiteTensor* input;
@@ -292,22 +392,45 @@ EI_IMPULSE_ERROR run_nn_inference(
     TfLiteTensor* output_labels;
     uint64_t ctx_start_us = ei_read_timer_us();
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
+    ei_tflite_micro_resident_t *resident = nullptr;
 
-    tflite::MicroInterpreter* interpreter;
-    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
-        block_config,
-        &ctx_start_us,
-        &input, &output,
-        &output_labels,
-        &output_scores,
-        &interpreter,
-        p_tensor_arena);
+    tflite::MicroInterpreter* interpreter = nullptr;
+    uint8_t* tensor_arena;
 
-    if (init_res != EI_IMPULSE_OK) {
-        return init_res;
+    if (handle->state.is_resident) {
+        EI_IMPULSE_ERROR init_res = inference_tflite_resident_get(handle, learn_block_index, block_config, &resident);
+        if (init_res != EI_IMPULSE_OK) {
+            return init_res;
+        }
+
+        input = resident->input;
+        output = resident->output;
+        output_labels = resident->output_labels;
+        output_scores = resident->output_scores;
+        interpreter = resident->interpreter;
+        tensor_arena = resident->tensor_arena;
+    }
+    else {
+        EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+            block_config,
+            &ctx_start_us,
+            &input, &output,
+            &output_labels,
+            &output_scores,
+            &interpreter,
+            p_tensor_arena);
+
+        if (init_res != EI_IMPULSE_OK) {
+            delete interpreter;
+            return init_res;
+        }
+
+        tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
     }
 
-    uint8_t* tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
+    // the interpreter is only owned here when it's not resident
+    ei_unique_ptr_t p_interpreter(resident ? nullptr : interpreter,
+        [](void *ptr) { delete static_cast<tflite::MicroInterpreter*>(ptr); });
 
     size_t mtx_size = impulse->dsp_blocks_size + impulse->learning_blocks_size;
     auto input_res = fill_input_tensor_from_matrix(fmatrix, input, input_block_ids, input_block_ids_size, mtx_size);
@@ -347,12 +470,13 @@ EI_IMPULSE_ERROR run_nn_inference(
  * returns EI_IMPULSE_OK.
  */
 EI_IMPULSE_ERROR run_nn_inference_image_quantized(
-    const ei_impulse_t *impulse,
+    ei_impulse_handle_t *handle,
     signal_t *signal,
     ei_impulse_result_t *result,
     void *config_ptr,
     bool debug = false)
 {
+    const ei_impulse_t *impulse = handle->impulse;
     ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
 
     memset(result, 0, sizeof(ei_impulse_result_t));
@@ -363,20 +487,45 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     TfLiteTensor* output_scores;
     TfLiteTensor* output_labels;
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
+    ei_tflite_micro_resident_t *resident = nullptr;
 
-    tflite::MicroInterpreter* interpreter;
-    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
-        block_config,
-        &ctx_start_us,
-        &input, &output,
-        &output_labels,
-        &output_scores,
-        &interpreter,
-        p_tensor_arena);
+    tflite::MicroInterpreter* interpreter = nullptr;
+    uint8_t* tensor_arena;
 
-    if (init_res != EI_IMPULSE_OK) {
-        return init_res;
+    if (handle->state.is_resident) {
+        EI_IMPULSE_ERROR init_res = inference_tflite_resident_get(handle, 0, block_config, &resident);
+        if (init_res != EI_IMPULSE_OK) {
+            return init_res;
+        }
+
+        input = resident->input;
+        output = resident->output;
+        output_labels = resident->output_labels;
+        output_scores = resident->output_scores;
+        interpreter = resident->interpreter;
+        tensor_arena = resident->tensor_arena;
     }
+    else {
+        EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+            block_config,
+            &ctx_start_us,
+            &input, &output,
+            &output_labels,
+            &output_scores,
+            &interpreter,
+            p_tensor_arena);
+
+        if (init_res != EI_IMPULSE_OK) {
+            delete interpreter;
+            return init_res;
+        }
+
+        tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
+    }
+
+    // the interpreter is only owned here when it's not resident
+    ei_unique_ptr_t p_interpreter(resident ? nullptr : interpreter,
+        [](void *ptr) { delete static_cast<tflite::MicroInterpreter*>(ptr); });
 
     if (input->type != TfLiteType::kTfLiteInt8 && input->type != TfLiteType::kTfLiteUInt8) {
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
@@ -395,7 +544,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return EI_IMPULSE_DSP_ERROR;
     }
 
-    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+    if (ei_run_impulse_check_deadline() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
     }
 
@@ -420,7 +569,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         output_labels,
         output_scores,
         interpreter,
-        static_cast<uint8_t*>(p_tensor_arena.get()),
+        tensor_arena,
         result, debug);
 
     if (run_res != EI_IMPULSE_OK) {
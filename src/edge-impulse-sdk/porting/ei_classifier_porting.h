@@ -37,6 +37,19 @@ EI_IMPULSE_ERROR ei_sleep(int32_t time_ms);
  */
 EI_IMPULSE_ERROR ei_run_impulse_check_canceled();
 
+/**
+ * Set the deadline of the running impulse, as a ei_read_timer_us() timestamp
+ * (0 = no deadline)
+ */
+void ei_run_impulse_set_deadline(uint64_t deadline_us);
+
+/**
+ * Cancellation point used between DSP blocks, operators and post-processing steps.
+ * Returns EI_IMPULSE_CANCELED once the deadline has passed, or if
+ * ei_run_impulse_check_canceled() does
+ */
+EI_IMPULSE_ERROR ei_run_impulse_check_deadline();
+
 /**
  * Read the millisecond timer
  */
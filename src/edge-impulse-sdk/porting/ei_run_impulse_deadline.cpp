@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+// Shared by all targets: only needs ei_read_timer_us() from the porting layer.
+// The deadline belongs to the thread running the impulse.
+static thread_local uint64_t ei_run_impulse_deadline_us = 0;
+
+void ei_run_impulse_set_deadline(uint64_t deadline_us) {
+    ei_run_impulse_deadline_us = deadline_us;
+}
+
+EI_IMPULSE_ERROR ei_run_impulse_check_deadline() {
+    if (ei_run_impulse_deadline_us != 0 && ei_read_timer_us() >= ei_run_impulse_deadline_us) {
+        return EI_IMPULSE_CANCELED;
+    }
+
+    return ei_run_impulse_check_canceled();
+}
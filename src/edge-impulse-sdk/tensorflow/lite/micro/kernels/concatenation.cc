@@ -15,6 +15,7 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/concatenation.h"
 
 #include <cstdint>
+#include <cstring>
 
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
@@ -37,6 +38,9 @@ constexpr int kOutputTensor = 0;
 
 struct OpData {
   ConcatenationParams params;
+  // All dimensions before the axis are 1: each input is one contiguous slice
+  // of the output, which the memory planner may have aliased in place.
+  bool contiguous;
 };
 
 // Handles negative axis index, coerces to positive index value.
@@ -102,6 +106,19 @@ void EvalUnquantized(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData* data = static_cast<const OpData*>(node->user_data);
 
+  if (data->contiguous) {
+    data_type* output_data = tflite::micro::GetTensorData<data_type>(output);
+    for (int i = 0; i < node->inputs->size; ++i) {
+      const int size = inputs_shape[i].FlatSize();
+      // Aliased inputs were written in place by their producer.
+      if (inputs_data[i] != output_data) {
+        std::memcpy(output_data, inputs_data[i], size * sizeof(data_type));
+      }
+      output_data += size;
+    }
+    return;
+  }
+
   reference_ops::Concatenation(data->params, inputs_shape_ptr, inputs_data,
                                tflite::micro::GetTensorShape(output),
                                tflite::micro::GetTensorData<data_type>(output));
@@ -214,6 +231,12 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
   }
 
+  int outer_size = 1;
+  for (int i = 0; i < data->params.axis; ++i) {
+    outer_size *= SizeOfDimension(output, i);
+  }
+  data->contiguous = outer_size == 1;
+
   micro_context->DeallocateTempTfLiteTensor(output);
 
   return kTfLiteOk;
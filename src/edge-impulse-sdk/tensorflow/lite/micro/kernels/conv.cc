@@ -1699,15 +1699,10 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_log.h"
 
-#include <esp_timer.h>
-
 #if ESP_NN
 #include "edge-impulse-sdk/porting/espressif/ESP-NN/include/esp_nn.h"
 #endif
 
-
-long long conv_total_time = 0;
-
 namespace tflite {
 namespace {
 
@@ -1808,6 +1803,13 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     } else {
       data->buffer_idx = -1;
     }
+
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0 && EI_TFLITE_CONV_PREPACK_ESP_NN
+    // ESP-NN only takes OHWI filters: the copy moves the filter out of flash
+    // to an aligned address, and unpadded layers use the folded bias.
+    TF_LITE_ENSURE_STATUS(ConvPrepackWeights(
+        context, node, ConvPrepackLayout::kOhwi, &data->op_data));
+#endif
   }
 #endif
 
@@ -1827,6 +1829,14 @@ inline void EvalQuantizedPerChannel(
     TfLiteEvalTensor* output) {
   const int dilation_width_factor = params.dilation_width_factor;
   const int dilation_height_factor = params.dilation_height_factor;
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0 && EI_TFLITE_CONV_PREPACK_ESP_NN
+  const int8_t* filter_data =
+      data.op_data.prepacked_filter != nullptr
+          ? data.op_data.prepacked_filter
+          : tflite::micro::GetTensorData<int8_t>(filter);
+#else
+  const int8_t* filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+#endif
 
   if (dilation_width_factor == 1 && dilation_height_factor == 1) {
     // Get parameters.
@@ -1838,12 +1848,24 @@ inline void EvalQuantizedPerChannel(
     const int8_t *input_data = tflite::micro::GetTensorData<int8_t>(input);
     int8_t *output_data = tflite::micro::GetTensorData<int8_t>(output);
 
-    const int32_t input_offset = -data.op_data.input_zero_point;
+    int32_t input_offset = -data.op_data.input_zero_point;
     const int32_t output_offset = data.op_data.output_zero_point;
     const int stride_width = params.stride_width;
     const int stride_height = params.stride_height;
     const int pad_width = data.op_data.padding.width;
     const int pad_height = data.op_data.padding.height;
+    const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0 && EI_TFLITE_CONV_PREPACK_ESP_NN
+    // Without padding every tap reads the image, so the input offset can come
+    // from the folded bias instead of being recomputed on every call.
+    if (data.op_data.folded_bias != nullptr && pad_width == 0 &&
+        pad_height == 0 && data.op_data.padding.width_offset == 0 &&
+        data.op_data.padding.height_offset == 0) {
+      input_offset = 0;
+      bias_data = data.op_data.folded_bias;
+    }
+#endif
 
     const int input_height = input_shape.Dims(1);
     const int input_width = input_shape.Dims(2);
@@ -1901,8 +1923,7 @@ inline void EvalQuantizedPerChannel(
 
     for (int i_batch = 0; i_batch < batch_size; i_batch++) {
       esp_nn_conv_s8(&input_dims, input_data + i_batch * input_size,
-                     &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
-                     tflite::micro::GetTensorData<int32_t>(bias),
+                     &filter_dims, filter_data, bias_data,
                      &output_dims, output_data + i_batch * output_size,
                      &conv_params, &quant_data);
     }
@@ -1913,8 +1934,7 @@ inline void EvalQuantizedPerChannel(
         data.op_data.per_channel_output_shift,
         tflite::micro::GetTensorShape(input),
         tflite::micro::GetTensorData<int8_t>(input),
-        tflite::micro::GetTensorShape(filter),
-        tflite::micro::GetTensorData<int8_t>(filter),
+        tflite::micro::GetTensorShape(filter), filter_data,
         tflite::micro::GetTensorShape(bias),
         tflite::micro::GetTensorData<int32_t>(bias),
         tflite::micro::GetTensorShape(output),
@@ -1945,7 +1965,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_MSG(context, input->type == filter->type,
                      "Hybrid models are not supported on TFLite Micro.");
 
-  long long start_time = esp_timer_get_time();
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
 #if EI_TFLITE_DISABLE_CONV_2D_IN_F32
@@ -2016,9 +2035,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                          TfLiteTypeGetName(input->type), input->type);
       return kTfLiteError;
   }
-  long long time_this_instance = esp_timer_get_time() - start_time;
-  conv_total_time += time_this_instance;
-  //printf("time this instance: %llu\n", time_this_instance / 1000);
   return kTfLiteOk;
 }
 
@@ -2174,6 +2190,19 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           break;
         }
         case kTfLiteInt8: {
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0
+          if (data.prepacked_filter != nullptr) {
+            ConvPerChannelPrepacked(
+                ConvParamsQuantized(params, data), data,
+                tflite::micro::GetTensorShape(input),
+                tflite::micro::GetTensorData<int8_t>(input),
+                tflite::micro::GetTensorShape(filter),
+                tflite::micro::GetOptionalTensorData<int32_t>(bias),
+                tflite::micro::GetTensorShape(output),
+                tflite::micro::GetTensorData<int8_t>(output));
+            break;
+          }
+#endif
           reference_integer_ops::ConvPerChannel(
               ConvParamsQuantized(params, data),
               data.per_channel_output_multiplier, data.per_channel_output_shift,
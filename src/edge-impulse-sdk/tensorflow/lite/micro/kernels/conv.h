@@ -22,6 +22,23 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/types.h"
 
+// Opt-in weight prepacking for int8 convolutions: Prepare copies constant
+// filters into the layout the kernel reads, and folds the input zero point
+// into the bias. This is the total number of bytes of persistent arena all
+// the prepacked layers of an interpreter may take, layers are prepacked in
+// graph order while they fit. The arena must be grown by the same amount.
+// 0 disables prepacking and compiles it out, so OpDataConv keeps its size.
+#ifndef EI_TFLITE_CONV_PREPACK_BUDGET
+#define EI_TFLITE_CONV_PREPACK_BUDGET 0
+#endif
+
+// The ESP-NN kernels only take prepacked filters when this is also 1: that
+// path has only been checked bit-exact against ESP-NN's generic C kernels,
+// not against the ESP32-S3 assembly.
+#ifndef EI_TFLITE_CONV_PREPACK_ESP_NN
+#define EI_TFLITE_CONV_PREPACK_ESP_NN 0
+#endif
+
 namespace tflite {
 
 struct OpDataConv {
@@ -49,8 +66,24 @@ struct OpDataConv {
   // A buffer used to store unpacked filter values. This is used if the source
   // tensor is of n-bit precision that cannot be easily processed by kernels.
   int filter_buffer_index;
+
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0
+  // Filter copied by ConvPrepackWeights, nullptr if the layer is not
+  // prepacked. folded_bias[o] is bias[o] + input_offset * sum(filter[o]).
+  int8_t* prepacked_filter;
+  int32_t* folded_bias;
+#endif
 };
 
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0
+// Layouts of a prepacked filter. kOhwi is an aligned copy of the tensor,
+// kBlocked interleaves groups of kConvPrepackBlock output channels as
+// [out / block][filter_y][filter_x][in][block], zero padding the last group.
+enum class ConvPrepackLayout { kOhwi, kBlocked };
+
+constexpr int kConvPrepackBlock = 4;
+#endif  // EI_TFLITE_CONV_PREPACK_BUDGET > 0
+
 extern const int kConvInputTensor;
 extern const int kConvWeightsTensor;
 extern const int kConvBiasTensor;
@@ -76,6 +109,27 @@ TfLiteStatus CalculateOpDataConv(TfLiteContext* context, TfLiteNode* node,
 
 TfLiteStatus ConvPrepare(TfLiteContext* context, TfLiteNode* node);
 
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0
+// Fills data->prepacked_filter and data->folded_bias when the layer is int8
+// with constant filter and bias and still fits in what is left of
+// EI_TFLITE_CONV_PREPACK_BUDGET for this interpreter.
+// Otherwise, or if the arena is full, leaves them nullptr. Must run after
+// CalculateOpDataConv.
+TfLiteStatus ConvPrepackWeights(TfLiteContext* context, TfLiteNode* node,
+                                ConvPrepackLayout layout, OpDataConv* data);
+
+// Int8 convolution over a kBlocked filter. Produces the same output as
+// reference_integer_ops::ConvPerChannel.
+void ConvPerChannelPrepacked(const ConvParams& params,
+                             const OpDataConv& data,
+                             const RuntimeShape& input_shape,
+                             const int8_t* input_data,
+                             const RuntimeShape& filter_shape,
+                             const int32_t* bias_data,
+                             const RuntimeShape& output_shape,
+                             int8_t* output_data);
+#endif  // EI_TFLITE_CONV_PREPACK_BUDGET > 0
+
 // This is the most generic TfLiteRegistration. The actual supported types may
 // still be target dependent. The only requirement is that every implementation
 // (reference or optimized) must define this function.
@@ -13,13 +13,18 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <cstring>
+
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/c_api_types.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/padding.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/conv.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_helpers.h"
 
 namespace tflite {
 
@@ -32,6 +37,59 @@ const int kConvOutputTensor = 0;
 // https://www.tensorflow.org/lite/performance/quantization_spec
 const int kConvQuantizedDimension = 0;
 
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0
+namespace {
+
+// Accumulates one group of kConvPrepackBlock output channels at one output
+// position. Inside the image the input offset is already in the folded bias,
+// on the border it has to be added to the taps that fall inside the image.
+template <bool kBorder>
+inline void AccumulatePrepackedBlock(const int8_t* input_data,
+                                     const RuntimeShape& input_shape,
+                                     int batch, int in_y_origin,
+                                     int in_x_origin, const ConvParams& params,
+                                     int filter_height, int filter_width,
+                                     const int8_t* filter_data,
+                                     int32_t* acc) {
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int input_depth = input_shape.Dims(3);
+  const int32_t input_offset = params.input_offset;
+
+  for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+    const int in_y = in_y_origin + params.dilation_height_factor * filter_y;
+    if (kBorder && (in_y < 0 || in_y >= input_height)) {
+      continue;
+    }
+    for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+      const int in_x = in_x_origin + params.dilation_width_factor * filter_x;
+      if (kBorder && (in_x < 0 || in_x >= input_width)) {
+        continue;
+      }
+      const int8_t* input_ptr =
+          input_data + Offset(input_shape, batch, in_y, in_x, 0);
+      const int8_t* filter_ptr =
+          filter_data +
+          (filter_y * filter_width + filter_x) * input_depth * kConvPrepackBlock;
+
+      for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
+        int32_t input_val = input_ptr[in_channel];
+        if (kBorder) {
+          input_val += input_offset;
+        }
+        acc[0] += filter_ptr[0] * input_val;
+        acc[1] += filter_ptr[1] * input_val;
+        acc[2] += filter_ptr[2] * input_val;
+        acc[3] += filter_ptr[3] * input_val;
+        filter_ptr += kConvPrepackBlock;
+      }
+    }
+  }
+}
+
+}  // namespace
+#endif  // EI_TFLITE_CONV_PREPACK_BUDGET > 0
+
 // Returns a ConvParams struct with all the parameters needed for a
 // float computation.
 ConvParams ConvParamsFloat(const TfLiteConvParams& params,
@@ -119,6 +177,10 @@ TfLiteStatus CalculateOpDataConv(TfLiteContext* context, TfLiteNode* node,
   data->input_zero_point = input->params.zero_point;
   data->filter_zero_point = filter->params.zero_point;
   data->output_zero_point = output->params.zero_point;
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0
+  data->prepacked_filter = nullptr;
+  data->folded_bias = nullptr;
+#endif
 
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(filter);
@@ -199,6 +261,184 @@ TfLiteStatus ConvPrepare(TfLiteContext* context, TfLiteNode* node) {
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(output);
 
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0
+  return ConvPrepackWeights(context, node, ConvPrepackLayout::kBlocked, data);
+#else
+  return kTfLiteOk;
+#endif
+}
+
+#if EI_TFLITE_CONV_PREPACK_BUDGET > 0
+TfLiteStatus ConvPrepackWeights(TfLiteContext* context, TfLiteNode* node,
+                                ConvPrepackLayout layout, OpDataConv* data) {
+  data->prepacked_filter = nullptr;
+  data->folded_bias = nullptr;
+
+  MicroContext* micro_context = GetMicroContext(context);
+
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kConvInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  TfLiteTensor* filter =
+      micro_context->AllocateTempInputTensor(node, kConvWeightsTensor);
+  TF_LITE_ENSURE(context, filter != nullptr);
+  TfLiteTensor* bias =
+      micro_context->AllocateTempInputTensor(node, kConvBiasTensor);
+
+  // Grouped convolutions keep the reference kernel.
+  const bool supported =
+      input->type == kTfLiteInt8 && filter->type == kTfLiteInt8 &&
+      IsConstantTensor(filter) && filter->dims->size == 4 &&
+      filter->dims->data[3] == input->dims->data[3] &&
+      (bias == nullptr ||
+       (bias->type == kTfLiteInt32 && IsConstantTensor(bias)));
+
+  if (supported) {
+    const int output_depth = filter->dims->data[kConvQuantizedDimension];
+    const int filter_depth = filter->dims->data[1] * filter->dims->data[2] *
+                             filter->dims->data[3];
+    const int padded_depth =
+        layout == ConvPrepackLayout::kBlocked
+            ? (output_depth + kConvPrepackBlock - 1) / kConvPrepackBlock *
+                  kConvPrepackBlock
+            : output_depth;
+    const size_t filter_bytes = AlignSizeUp(
+        static_cast<size_t>(padded_depth) * filter_depth, alignof(int32_t));
+    const size_t bytes = filter_bytes + padded_depth * sizeof(int32_t);
+
+    uint8_t* buffer =
+        micro_context->conv_prepack_bytes() + bytes <=
+                EI_TFLITE_CONV_PREPACK_BUDGET
+            ? static_cast<uint8_t*>(
+                  context->AllocatePersistentBuffer(context, bytes))
+            : nullptr;
+
+    if (buffer != nullptr) {
+      micro_context->add_conv_prepack_bytes(bytes);
+      int8_t* prepacked = reinterpret_cast<int8_t*>(buffer);
+      int32_t* folded_bias = reinterpret_cast<int32_t*>(buffer + filter_bytes);
+      const int8_t* filter_data = filter->data.int8;
+      const int32_t input_offset = -data->input_zero_point;
+      memset(buffer, 0, bytes);
+
+      for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+        const int8_t* src = filter_data + out_channel * filter_depth;
+        int32_t sum = 0;
+        for (int i = 0; i < filter_depth; ++i) {
+          sum += src[i];
+        }
+        folded_bias[out_channel] =
+            (bias != nullptr ? bias->data.i32[out_channel] : 0) +
+            input_offset * sum;
+
+        if (layout == ConvPrepackLayout::kOhwi) {
+          memcpy(prepacked + out_channel * filter_depth, src, filter_depth);
+        } else {
+          int8_t* dst = prepacked +
+                        out_channel / kConvPrepackBlock * filter_depth *
+                            kConvPrepackBlock +
+                        out_channel % kConvPrepackBlock;
+          for (int i = 0; i < filter_depth; ++i) {
+            dst[i * kConvPrepackBlock] = src[i];
+          }
+        }
+      }
+
+      data->prepacked_filter = prepacked;
+      data->folded_bias = folded_bias;
+    }
+  }
+
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(filter);
+  if (bias != nullptr) {
+    micro_context->DeallocateTempTfLiteTensor(bias);
+  }
+
   return kTfLiteOk;
 }
+
+void ConvPerChannelPrepacked(const ConvParams& params,
+                             const OpDataConv& data,
+                             const RuntimeShape& input_shape,
+                             const int8_t* input_data,
+                             const RuntimeShape& filter_shape,
+                             const int32_t* bias_data,
+                             const RuntimeShape& output_shape,
+                             int8_t* output_data) {
+  TFLITE_DCHECK(data.prepacked_filter != nullptr);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int block_size =
+      filter_height * filter_width * input_depth * kConvPrepackBlock;
+  const int filter_span_y =
+      (filter_height - 1) * params.dilation_height_factor + 1;
+  const int filter_span_x = (filter_width - 1) * params.dilation_width_factor + 1;
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin =
+          (out_y * params.stride_height) - params.padding_values.height;
+      const bool inside_y =
+          in_y_origin >= 0 && in_y_origin + filter_span_y <= input_height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin =
+            (out_x * params.stride_width) - params.padding_values.width;
+        const bool inside =
+            inside_y && in_x_origin >= 0 &&
+            in_x_origin + filter_span_x <= input_width;
+        int8_t* output_ptr =
+            output_data + Offset(output_shape, batch, out_y, out_x, 0);
+
+        for (int block_start = 0; block_start < output_depth;
+             block_start += kConvPrepackBlock) {
+          const int8_t* block_filter =
+              data.prepacked_filter +
+              block_start / kConvPrepackBlock * block_size;
+          int32_t acc[kConvPrepackBlock];
+          if (inside) {
+            memcpy(acc, data.folded_bias + block_start, sizeof(acc));
+            AccumulatePrepackedBlock<false>(
+                input_data, input_shape, batch, in_y_origin, in_x_origin,
+                params, filter_height, filter_width, block_filter, acc);
+          } else {
+            memset(acc, 0, sizeof(acc));
+            AccumulatePrepackedBlock<true>(
+                input_data, input_shape, batch, in_y_origin, in_x_origin,
+                params, filter_height, filter_width, block_filter, acc);
+          }
+
+          const int block_end =
+              std::min(block_start + kConvPrepackBlock, output_depth);
+          for (int out_channel = block_start; out_channel < block_end;
+               ++out_channel) {
+            int32_t value = acc[out_channel - block_start];
+            if (!inside && bias_data) {
+              value += bias_data[out_channel];
+            }
+            value = MultiplyByQuantizedMultiplier(
+                value, data.per_channel_output_multiplier[out_channel],
+                data.per_channel_output_shift[out_channel]);
+            value += params.output_offset;
+            value = std::max(value, params.quantized_activation_min);
+            value = std::min(value, params.quantized_activation_max);
+            output_ptr[out_channel] = static_cast<int8_t>(value);
+          }
+        }
+      }
+    }
+  }
+}
+#endif  // EI_TFLITE_CONV_PREPACK_BUDGET > 0
+
 }  // namespace tflite
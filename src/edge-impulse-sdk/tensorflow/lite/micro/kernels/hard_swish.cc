@@ -25,6 +25,7 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/op_macros.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/hard_swish.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/lookup_table.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_log.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_utils.h"
 
@@ -51,12 +52,20 @@ TfLiteStatus HardSwishEval(TfLiteContext* context, TfLiteNode* node) {
           tflite::micro::GetTensorData<float>(output));
     } break;
     case kTfLiteInt8: {
+      const uint8_t* table = GetActivationLookupTable(node);
+      if (table != nullptr) {
+        EvalActivationLookupTable(table, input, output);
+        break;
+      }
       tflite::reference_ops::HardSwish<int8_t>(
           *params, tflite::micro::GetTensorShape(input),
           tflite::micro::GetTensorData<int8_t>(input),
           tflite::micro::GetTensorShape(output),
           tflite::micro::GetTensorData<int8_t>(output));
     } break;
+    case kTfLiteUInt8: {
+      EvalActivationLookupTable(GetActivationLookupTable(node), input, output);
+    } break;
     default: {
       MicroPrintf("Unsupported type %s", TfLiteTypeGetName(input->type));
       return kTfLiteError;
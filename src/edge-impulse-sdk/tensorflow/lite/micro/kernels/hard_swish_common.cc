@@ -24,6 +24,7 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/op_macros.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/hard_swish.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/lookup_table.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_utils.h"
 
 namespace tflite {
@@ -45,11 +46,13 @@ TfLiteStatus HardSwishPrepare(TfLiteContext* context, TfLiteNode* node) {
       micro_context->AllocateTempOutputTensor(node, kHardSwishOutputTensor);
   TF_LITE_ENSURE(context, output != nullptr);
 
-  if (input->type == kTfLiteInt8) {
+  if (input->type == kTfLiteInt8 || input->type == kTfLiteUInt8) {
     HardSwishParams* params = static_cast<HardSwishParams*>(node->user_data);
+    // uint8 is evaluated as int8 with zero points shifted by -128.
+    const int32_t zero_point_offset = input->type == kTfLiteUInt8 ? 128 : 0;
 
-    params->input_zero_point = input->params.zero_point;
-    params->output_zero_point = output->params.zero_point;
+    params->input_zero_point = input->params.zero_point - zero_point_offset;
+    params->output_zero_point = output->params.zero_point - zero_point_offset;
 
     const float input_scale = input->params.scale;
     const float hires_input_scale = (1.0f / 128.0f) * input_scale;
@@ -75,6 +78,18 @@ TfLiteStatus HardSwishPrepare(TfLiteContext* context, TfLiteNode* node) {
     DownScaleInt32ToInt16Multiplier(
         reluish_multiplier_fixedpoint_int32,
         &params->reluish_multiplier_fixedpoint_int16);
+
+    const HardSwishParams table_params = *params;
+    const RuntimeShape shape(1, 1);
+    uint8_t* table = AllocateActivationLookupTable(
+        context, input->type,
+        [&table_params, &shape](const int8_t* in, int8_t* out) {
+          reference_ops::HardSwish<int8_t>(table_params, shape, in, shape,
+                                           out);
+        });
+    SetActivationLookupTable(node, table);
+    // There is no reference uint8 kernel to fall back to.
+    TF_LITE_ENSURE(context, input->type == kTfLiteInt8 || table != nullptr);
   }
 
   micro_context->DeallocateTempTfLiteTensor(input);
@@ -25,6 +25,7 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/op_macros.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/logistic.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/lookup_table.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -78,6 +79,11 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
   } else if (input->type == kTfLiteInt8) {
     switch (output->type) {
       case kTfLiteInt8: {
+        const uint8_t* table = GetActivationLookupTable(node);
+        if (table != nullptr) {
+          EvalActivationLookupTable(table, input, output);
+          return kTfLiteOk;
+        }
         reference_integer_ops::Logistic(
             data->input_zero_point, data->input_range_radius,
             data->input_multiplier, data->input_left_shift,
@@ -92,6 +98,9 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
                     TfLiteTypeGetName(output->type));
         return kTfLiteError;
     }
+  } else if (input->type == kTfLiteUInt8 && output->type == kTfLiteUInt8) {
+    EvalActivationLookupTable(GetActivationLookupTable(node), input, output);
+    return kTfLiteOk;
   } else {
     // TODO(b/141211002): Also support other data types once we have supported
     // temporary tensors in TFLM.
@@ -24,6 +24,7 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/op_macros.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/logistic.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/lookup_table.h"
 
 namespace tflite {
 const int kLogisticInputTensor = 0;
@@ -42,8 +43,10 @@ TfLiteStatus CalculateArithmeticOpDataLogistic(TfLiteContext* context,
   TF_LITE_ENSURE(context, output != nullptr);
 
   TF_LITE_ENSURE_TYPES_EQ(context, input->type, output->type);
-  if (input->type == kTfLiteInt8) {
-    TF_LITE_ENSURE_EQ(context, output->params.zero_point,
+  if (input->type == kTfLiteInt8 || input->type == kTfLiteUInt8) {
+    // uint8 is evaluated as int8 with zero points shifted by -128.
+    const int32_t zero_point_offset = input->type == kTfLiteUInt8 ? 128 : 0;
+    TF_LITE_ENSURE_EQ(context, output->params.zero_point - zero_point_offset,
                       std::numeric_limits<int8_t>::min());
 
     static constexpr int kInputIntegerBits = 4;
@@ -51,13 +54,24 @@ TfLiteStatus CalculateArithmeticOpDataLogistic(TfLiteContext* context,
         static_cast<double>(input->params.scale) *
         static_cast<double>(1 << (31 - kInputIntegerBits));
 
-    data->input_zero_point = input->params.zero_point;
+    data->input_zero_point = input->params.zero_point - zero_point_offset;
 
     const double q = std::frexp(input_real_multiplier, &data->input_left_shift);
     data->input_multiplier = static_cast<int32_t>(TfLiteRound(q * (1ll << 31)));
 
     data->input_range_radius =
         CalculateInputRadius(kInputIntegerBits, data->input_left_shift, 31);
+
+    const OpDataLogistic params = *data;
+    uint8_t* table = AllocateActivationLookupTable(
+        context, input->type, [&params](const int8_t* in, int8_t* out) {
+          reference_integer_ops::Logistic(
+              params.input_zero_point, params.input_range_radius,
+              params.input_multiplier, params.input_left_shift, 1, in, out);
+        });
+    SetActivationLookupTable(node, table);
+    // There is no reference uint8 kernel to fall back to.
+    TF_LITE_ENSURE(context, input->type == kTfLiteInt8 || table != nullptr);
   }
 
   if (input->type == kTfLiteInt16) {
@@ -0,0 +1,92 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_LOOKUP_TABLE_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_LOOKUP_TABLE_H_
+
+#include <cstdint>
+
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/types.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
+
+namespace tflite {
+
+// Elementwise 8-bit activations only ever see 256 input values, so Prepare
+// runs the reference kernel once per value and Eval is a table lookup.
+// Define EI_TFLITE_DISABLE_ACTIVATION_LUT=1 to keep the reference kernels and
+// save the 256 bytes of persistent arena per node.
+
+constexpr int kActivationLookupTableSize = 256;
+
+// Allocates a table from the persistent arena, mapping every raw input byte to
+// the raw output byte. `op(const int8_t* input, int8_t* output)` evaluates one
+// int8 element with the reference kernel. uint8 tensors are computed as int8
+// ones with both zero points shifted by -128, so for them `op` must be built
+// from the shifted zero points.
+// Returns nullptr when tables are disabled or the arena is full: the caller
+// then keeps the reference kernel.
+template <typename Op>
+uint8_t* AllocateActivationLookupTable(TfLiteContext* context, TfLiteType type,
+                                       Op op) {
+#if EI_TFLITE_DISABLE_ACTIVATION_LUT
+  return nullptr;
+#else
+  TFLITE_DCHECK(type == kTfLiteInt8 || type == kTfLiteUInt8);
+  uint8_t* table = static_cast<uint8_t*>(context->AllocatePersistentBuffer(
+      context, kActivationLookupTableSize));
+  if (table == nullptr) {
+    return nullptr;
+  }
+
+  const int offset = type == kTfLiteUInt8 ? 128 : 0;
+  for (int value = -128; value <= 127; ++value) {
+    const int8_t input = static_cast<int8_t>(value);
+    int8_t output;
+    op(&input, &output);
+    table[static_cast<uint8_t>(value + offset)] =
+        static_cast<uint8_t>(output + offset);
+  }
+  return table;
+#endif
+}
+
+// LOGISTIC, TANH and HARD_SWISH have no builtin options, so the table is kept
+// in node->builtin_data rather than in the op data allocated by Init: models
+// whose arena was sized for the original op data still fit.
+inline void SetActivationLookupTable(TfLiteNode* node, uint8_t* table) {
+  node->builtin_data = table;
+}
+
+inline const uint8_t* GetActivationLookupTable(const TfLiteNode* node) {
+  return static_cast<const uint8_t*>(node->builtin_data);
+}
+
+inline void EvalActivationLookupTable(const uint8_t* table,
+                                      const TfLiteEvalTensor* input,
+                                      TfLiteEvalTensor* output) {
+  const int size = MatchingFlatSize(tflite::micro::GetTensorShape(input),
+                                    tflite::micro::GetTensorShape(output));
+  const uint8_t* input_data = tflite::micro::GetTensorData<uint8_t>(input);
+  uint8_t* output_data = tflite::micro::GetTensorData<uint8_t>(output);
+
+  for (int i = 0; i < size; ++i) {
+    output_data[i] = table[input_data[i]];
+  }
+}
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_LOOKUP_TABLE_H_
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/resize_nearest_neighbor.h"
 
+#include <cstring>
+
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/tensor_ctypes.h"
@@ -32,6 +34,96 @@ constexpr int kInputTensor = 0;
 constexpr int kSizeTensor = 1;
 constexpr int kOutputTensor = 0;
 
+struct OpData {
+  // Integer upscale factors when the resize is plain pixel/row duplication,
+  // 0 to run the reference kernel.
+  int scale_height;
+  int scale_width;
+};
+
+// Used when Init got no persistent memory (e.g. an arena sized before OpData
+// existed): the node keeps the reference kernel.
+constexpr OpData kReferenceOpData = {0, 0};
+
+// Returns the integer factor if every output coordinate of the reference
+// kernel (which Eval always runs without half pixel centers) maps to
+// output / factor, 0 otherwise.
+int DuplicationFactor(int input_size, int output_size, bool align_corners) {
+  if (align_corners || output_size < input_size ||
+      output_size % input_size != 0) {
+    return 0;
+  }
+  const int factor = output_size / input_size;
+  for (int i = 0; i < output_size; ++i) {
+    if (reference_ops::GetNearestNeighbor(i, input_size, output_size,
+                                          align_corners, false) != i / factor) {
+      return 0;
+    }
+  }
+  return factor;
+}
+
+// Writes each output row once, duplicating its pixels, then repeats the row.
+template <typename T>
+void ResizeNearestNeighborDuplicate(const OpData& data,
+                                    const RuntimeShape& input_shape,
+                                    const T* input_data, T* output_data) {
+  const int batches = input_shape.Dims(0);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int depth = input_shape.Dims(3);
+  const int output_row_size = input_width * data.scale_width * depth;
+
+  for (int b = 0; b < batches; ++b) {
+    for (int y = 0; y < input_height; ++y) {
+      const T* output_row = output_data;
+      for (int x = 0; x < input_width; ++x) {
+        if (depth == 1) {
+          for (int i = 0; i < data.scale_width; ++i) {
+            *output_data++ = *input_data;
+          }
+        } else {
+          for (int i = 0; i < data.scale_width; ++i) {
+            std::memcpy(output_data, input_data, depth * sizeof(T));
+            output_data += depth;
+          }
+        }
+        input_data += depth;
+      }
+      for (int i = 1; i < data.scale_height; ++i) {
+        std::memcpy(output_data, output_row, output_row_size * sizeof(T));
+        output_data += output_row_size;
+      }
+    }
+  }
+}
+
+template <typename T>
+void EvalResizeNearestNeighbor(const OpData& data,
+                               const ResizeNearestNeighborParams& op_params,
+                               const TfLiteEvalTensor* input,
+                               const TfLiteEvalTensor* size,
+                               TfLiteEvalTensor* output) {
+  if (data.scale_height > 0) {
+    ResizeNearestNeighborDuplicate(data, tflite::micro::GetTensorShape(input),
+                                   tflite::micro::GetTensorData<T>(input),
+                                   tflite::micro::GetTensorData<T>(output));
+    return;
+  }
+  reference_ops::ResizeNearestNeighbor(
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<T>(input),
+      tflite::micro::GetTensorShape(size),
+      tflite::micro::GetTensorData<int32_t>(size),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<T>(output));
+}
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   MicroContext* micro_context = GetMicroContext(context);
 
@@ -59,6 +151,20 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     return kTfLiteError;
   }
 
+  auto* params =
+      reinterpret_cast<TfLiteResizeNearestNeighborParams*>(node->builtin_data);
+  OpData* data = static_cast<OpData*>(node->user_data);
+  if (data != nullptr) {
+    const int32_t* size_data = GetTensorData<int32_t>(size);
+    data->scale_height = DuplicationFactor(
+        SizeOfDimension(input, 1), size_data[0], params->align_corners);
+    data->scale_width = DuplicationFactor(
+        SizeOfDimension(input, 2), size_data[1], params->align_corners);
+    if (data->scale_width == 0) {
+      data->scale_height = 0;
+    }
+  }
+
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(size);
   micro_context->DeallocateTempTfLiteTensor(output);
@@ -77,34 +183,20 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kOutputTensor);
 
+  const OpData& data = node->user_data != nullptr
+                           ? *static_cast<const OpData*>(node->user_data)
+                           : kReferenceOpData;
+
   tflite::ResizeNearestNeighborParams op_params;
   op_params.align_corners = params->align_corners;
   op_params.half_pixel_centers = false;
 
   if (output->type == kTfLiteFloat32) {
-    reference_ops::ResizeNearestNeighbor(
-        op_params, tflite::micro::GetTensorShape(input),
-        tflite::micro::GetTensorData<int32_t>(input),
-        tflite::micro::GetTensorShape(size),
-        tflite::micro::GetTensorData<int32_t>(size),
-        tflite::micro::GetTensorShape(output),
-        tflite::micro::GetTensorData<int32_t>(output));
+    EvalResizeNearestNeighbor<int32_t>(data, op_params, input, size, output);
   } else if (output->type == kTfLiteInt8) {
-    reference_ops::ResizeNearestNeighbor(
-        op_params, tflite::micro::GetTensorShape(input),
-        tflite::micro::GetTensorData<int8_t>(input),
-        tflite::micro::GetTensorShape(size),
-        tflite::micro::GetTensorData<int32_t>(size),
-        tflite::micro::GetTensorShape(output),
-        tflite::micro::GetTensorData<int8_t>(output));
+    EvalResizeNearestNeighbor<int8_t>(data, op_params, input, size, output);
   } else if (output->type == kTfLiteInt16) {
-    reference_ops::ResizeNearestNeighbor(
-        op_params, tflite::micro::GetTensorShape(input),
-        tflite::micro::GetTensorData<int16_t>(input),
-        tflite::micro::GetTensorShape(size),
-        tflite::micro::GetTensorData<int32_t>(size),
-        tflite::micro::GetTensorShape(output),
-        tflite::micro::GetTensorData<int16_t>(output));
+    EvalResizeNearestNeighbor<int16_t>(data, op_params, input, size, output);
   } else {
     MicroPrintf("Output tensor type %s (%d) not supported.",
                 TfLiteTypeGetName(output->type), output->type);
@@ -117,7 +209,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace resize_nearest_neighbor
 
 TfLiteRegistration Register_RESIZE_NEAREST_NEIGHBOR() {
-  return tflite::micro::RegisterOp(nullptr, resize_nearest_neighbor::Prepare,
+  return tflite::micro::RegisterOp(resize_nearest_neighbor::Init,
+                                   resize_nearest_neighbor::Prepare,
                                    resize_nearest_neighbor::Eval);
 }
 
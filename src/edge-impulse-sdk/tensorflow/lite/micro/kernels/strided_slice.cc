@@ -67,6 +67,29 @@ struct StridedSliceContext {
 // implementation, the 1-3D tensors are mapped to 4D.
 const int kMaxDim = 4;
 
+// Number of axes the reference implementation pads the shapes to.
+constexpr int kPaddedDims = 5;
+
+// How Eval copies the slice. Slices with positive strides are flattened to at most 4 outer loops around an inner run of
+// elements, with the input offsets precomputed per axis:
+//  - kCopy: the slice is one contiguous block (single memcpy)
+//  - kRows: unit stride on the inner run (one memcpy per row), e.g. channel
+//    slices or stride 2 spatial decimation of NHWC tensors
+//  - kGather: strided inner run (e.g. channel decimation)
+// Anything else (negative strides, empty slices) uses the reference kernel.
+// The plan is rebuilt from the StridedSliceParams on every Eval (a few index
+// computations per axis), so the persistent op data keeps its size.
+enum class StridedSliceKind : uint8_t { kReference, kCopy, kRows, kGather };
+
+struct StridedSliceFastPath {
+  StridedSliceKind kind;
+  int32_t start;                     // offset of the first element
+  int32_t count[kPaddedDims - 1];    // outer loops, outermost first
+  int32_t step[kPaddedDims - 1];     // input elements between two iterations
+  int32_t inner_count;               // elements per inner run
+  int32_t inner_step;                // input elements between two of them
+};
+
 tflite::StridedSliceParams BuildStridedSliceParams(
     StridedSliceContext* op_context) {
   tflite::StridedSliceParams op_params;
@@ -126,6 +149,154 @@ TfLiteStatus CheckOutputSize(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+// Flattens the slice into a StridedSliceFastPath, using the same start/stop
+// logic as reference_ops::StridedSlice so both copy the same elements.
+StridedSliceFastPath PlanStridedSlice(const StridedSliceParams& op_params,
+                                      const RuntimeShape& unextended_shape) {
+  StridedSliceFastPath plan = {};
+  StridedSliceParams params = op_params;
+  const RuntimeShape shape =
+      RuntimeShape::ExtendedShape(kPaddedDims, unextended_shape);
+  int32_t start[kPaddedDims];
+  int32_t count[kPaddedDims];
+  int32_t axis_step[kPaddedDims];
+
+  plan.kind = StridedSliceKind::kReference;
+  strided_slice::StridedSlicePadIndices(&params, kPaddedDims);
+
+  for (int axis = kPaddedDims - 1; axis >= 0; --axis) {
+    const int32_t stride = params.strides[axis];
+
+    axis_step[axis] = axis == kPaddedDims - 1
+                          ? 1
+                          : axis_step[axis + 1] * shape.Dims(axis + 1);
+
+    if (stride <= 0) {
+      return plan;
+    }
+
+    start[axis] =
+        strided_slice::StridedSliceStartForAxis(params, shape, axis);
+    const int32_t stop = strided_slice::StridedSliceEndForAxis(
+        params, shape, axis, start[axis]);
+
+    if (stop <= start[axis]) {
+      return plan;
+    }
+
+    count[axis] = (stop - start[axis] + stride - 1) / stride;
+    plan.start += start[axis] * axis_step[axis];
+  }
+
+  // Merge the innermost axes into one run while it stays contiguous:
+  // axis can join the run if every axis inside it is taken whole.
+  int first_inner = kPaddedDims - 1;
+  plan.inner_count = count[first_inner];
+  plan.inner_step = params.strides[first_inner];
+
+  if (plan.inner_step == 1) {
+    while (first_inner > 0 && start[first_inner] == 0 &&
+           count[first_inner] == shape.Dims(first_inner) &&
+           params.strides[first_inner] == 1 &&
+           params.strides[first_inner - 1] == 1) {
+      --first_inner;
+      plan.inner_count *= count[first_inner];
+    }
+  }
+
+  // Outer loops, padded with single iterations at the front.
+  const int outer_dims = kPaddedDims - 1;
+  const int pad = outer_dims - first_inner;
+  bool single_run = true;
+
+  for (int i = 0; i < outer_dims; ++i) {
+    const int axis = i - pad;
+
+    plan.count[i] = axis >= 0 ? count[axis] : 1;
+    plan.step[i] = axis >= 0 ? params.strides[axis] * axis_step[axis] : 0;
+    single_run = single_run && plan.count[i] == 1;
+  }
+
+  if (plan.inner_step != 1) {
+    plan.kind = StridedSliceKind::kGather;
+  } else if (single_run) {
+    plan.kind = StridedSliceKind::kCopy;
+  } else {
+    plan.kind = StridedSliceKind::kRows;
+  }
+
+  return plan;
+}
+
+template <typename T>
+void StridedSliceFast(const StridedSliceFastPath& plan, const T* input,
+                      T* output) {
+  const T* in_0 = input + plan.start;
+
+  if (plan.kind == StridedSliceKind::kCopy) {
+    memcpy(output, in_0, plan.inner_count * sizeof(T));
+    return;
+  }
+
+  const int32_t inner_count = plan.inner_count;
+  const int32_t inner_step = plan.inner_step;
+  const int32_t step_3 = plan.step[3];
+  const size_t row_bytes = inner_count * sizeof(T);
+  // short rows (e.g. a few channels) are cheaper to copy inline than to memcpy
+  const bool short_rows = row_bytes < 8;
+
+  for (int32_t i0 = 0; i0 < plan.count[0]; ++i0, in_0 += plan.step[0]) {
+    const T* in_1 = in_0;
+    for (int32_t i1 = 0; i1 < plan.count[1]; ++i1, in_1 += plan.step[1]) {
+      const T* in_2 = in_1;
+      for (int32_t i2 = 0; i2 < plan.count[2]; ++i2, in_2 += plan.step[2]) {
+        const T* in_3 = in_2;
+
+        if (plan.kind == StridedSliceKind::kRows && !short_rows) {
+          for (int32_t i3 = 0; i3 < plan.count[3]; ++i3, in_3 += step_3) {
+            memcpy(output, in_3, row_bytes);
+            output += inner_count;
+          }
+        } else if (plan.kind == StridedSliceKind::kRows) {
+          for (int32_t i3 = 0; i3 < plan.count[3]; ++i3, in_3 += step_3) {
+            for (int32_t i4 = 0; i4 < inner_count; ++i4) {
+              output[i4] = in_3[i4];
+            }
+            output += inner_count;
+          }
+        } else {
+          for (int32_t i3 = 0; i3 < plan.count[3]; ++i3, in_3 += step_3) {
+            const T* in_4 = in_3;
+            for (int32_t i4 = 0; i4 < inner_count; ++i4, in_4 += inner_step) {
+              *output++ = *in_4;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+void EvalStridedSlice(const StridedSliceParams& op_params,
+                      const TfLiteEvalTensor* input,
+                      TfLiteEvalTensor* output) {
+  const StridedSliceFastPath plan =
+      PlanStridedSlice(op_params, tflite::micro::GetTensorShape(input));
+
+  if (plan.kind != StridedSliceKind::kReference) {
+    StridedSliceFast(plan, tflite::micro::GetTensorData<T>(input),
+                     tflite::micro::GetTensorData<T>(output));
+    return;
+  }
+
+  reference_ops::StridedSlice(op_params,
+                              tflite::micro::GetTensorShape(input),
+                              tflite::micro::GetTensorData<T>(input),
+                              tflite::micro::GetTensorShape(output),
+                              tflite::micro::GetTensorData<T>(output));
+}
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
   return context->AllocatePersistentBuffer(context, sizeof(StridedSliceParams));
@@ -162,11 +333,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
       #endif
 
-      reference_ops::StridedSlice(op_params,
-                                  tflite::micro::GetTensorShape(input),
-                                  tflite::micro::GetTensorData<float>(input),
-                                  tflite::micro::GetTensorShape(output),
-                                  tflite::micro::GetTensorData<float>(output));
+      EvalStridedSlice<float>(op_params, input, output);
       break;
     case kTfLiteUInt8:
       #if EI_TFLITE_DISABLE_STRIDED_SLICE_OUT_U8
@@ -175,11 +342,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
       #endif
 
-      reference_ops::StridedSlice(
-          op_params, tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<uint8_t>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<uint8_t>(output));
+      EvalStridedSlice<uint8_t>(op_params, input, output);
       break;
     case kTfLiteInt8:
       #if EI_TFLITE_DISABLE_STRIDED_SLICE_OUT_I8
@@ -188,11 +351,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
       #endif
 
-      reference_ops::StridedSlice(op_params,
-                                  tflite::micro::GetTensorShape(input),
-                                  tflite::micro::GetTensorData<int8_t>(input),
-                                  tflite::micro::GetTensorShape(output),
-                                  tflite::micro::GetTensorData<int8_t>(output));
+      EvalStridedSlice<int8_t>(op_params, input, output);
       break;
     case kTfLiteInt16:
       #if EI_TFLITE_DISABLE_STRIDED_SLICE_OUT_I16
@@ -201,11 +360,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
       #endif
 
-      reference_ops::StridedSlice(
-          op_params, tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int16_t>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int16_t>(output));
+      EvalStridedSlice<int16_t>(op_params, input, output);
       break;
     case kTfLiteInt32:
       #if EI_TFLITE_DISABLE_STRIDED_SLICE_OUT_I32
@@ -214,11 +369,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
       #endif
 
-      reference_ops::StridedSlice(
-          op_params, tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int32_t>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int32_t>(output));
+      EvalStridedSlice<int32_t>(op_params, input, output);
       break;
     case kTfLiteBool:
       #if EI_TFLITE_DISABLE_STRIDED_SLICE_OUT_BOOL
@@ -227,11 +378,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
       #endif
 
-      reference_ops::StridedSlice(op_params,
-                                  tflite::micro::GetTensorShape(input),
-                                  tflite::micro::GetTensorData<bool>(input),
-                                  tflite::micro::GetTensorShape(output),
-                                  tflite::micro::GetTensorData<bool>(output));
+      EvalStridedSlice<bool>(op_params, input, output);
       break;
     default:
       MicroPrintf("Type %s (%d) not supported.", TfLiteTypeGetName(input->type),
@@ -24,6 +24,7 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/op_macros.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/lookup_table.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_log.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_utils.h"
 
@@ -61,7 +62,7 @@ TfLiteStatus CalculateArithmeticOpData(TfLiteContext* context, TfLiteNode* node,
 
   TF_LITE_ENSURE_TYPES_EQ(context, input->type, output->type);
 
-  if (input->type == kTfLiteInt8) {
+  if (input->type == kTfLiteInt8 || input->type == kTfLiteUInt8) {
     static constexpr int kInputIntegerBits = 4;
     const double input_real_multiplier =
         static_cast<double>(input->params.scale) *
@@ -72,6 +73,19 @@ TfLiteStatus CalculateArithmeticOpData(TfLiteContext* context, TfLiteNode* node,
 
     data->input_range_radius =
         CalculateInputRadius(kInputIntegerBits, data->input_left_shift, 31);
+
+    const OpData params = *data;
+    const RuntimeShape shape(1, 1);
+    uint8_t* table = AllocateActivationLookupTable(
+        context, input->type, [&params, &shape](const int8_t* in, int8_t* out) {
+          reference_integer_ops::Tanh(
+              params.input_zero_point, params.input_range_radius,
+              params.input_multiplier, params.input_left_shift, shape, in,
+              shape, out);
+        });
+    SetActivationLookupTable(node, table);
+    // There is no reference uint8 kernel to fall back to.
+    TF_LITE_ENSURE(context, input->type == kTfLiteInt8 || table != nullptr);
   }
 
   if (input->type == kTfLiteInt16) {
@@ -141,7 +155,9 @@ TfLiteStatus TanhPrepare(TfLiteContext* context, TfLiteNode* node) {
   TfLiteTensor* input =
       micro_context->AllocateTempInputTensor(node, kInputTensor);
   TF_LITE_ENSURE(context, input != nullptr);
-  data->input_zero_point = input->params.zero_point;
+  // uint8 is evaluated as int8 with zero points shifted by -128.
+  data->input_zero_point = input->params.zero_point -
+                           (input->type == kTfLiteUInt8 ? 128 : 0);
   TF_LITE_ENSURE_OK(context, CalculateArithmeticOpData(context, node, data));
 
   micro_context->DeallocateTempTfLiteTensor(input);
@@ -177,6 +193,11 @@ TfLiteStatus TanhEval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteOk;
     } break;
     case kTfLiteInt8: {
+      const uint8_t* table = GetActivationLookupTable(node);
+      if (table != nullptr) {
+        EvalActivationLookupTable(table, input, output);
+        return kTfLiteOk;
+      }
       reference_integer_ops::Tanh(
           data.input_zero_point, data.input_range_radius, data.input_multiplier,
           data.input_left_shift, tflite::micro::GetTensorShape(input),
@@ -185,6 +206,10 @@ TfLiteStatus TanhEval(TfLiteContext* context, TfLiteNode* node) {
           tflite::micro::GetTensorData<int8_t>(output));
       return kTfLiteOk;
     } break;
+    case kTfLiteUInt8: {
+      EvalActivationLookupTable(GetActivationLookupTable(node), input, output);
+      return kTfLiteOk;
+    } break;
     default:
       MicroPrintf("Input %s, output %s not supported.",
                   TfLiteTypeGetName(input->type),
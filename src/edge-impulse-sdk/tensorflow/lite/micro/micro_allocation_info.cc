@@ -22,13 +22,64 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/memory_helpers.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_arena_constants.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_log.h"
+#include "edge-impulse-sdk/tensorflow/lite/schema/schema_utils.h"
 
 namespace tflite {
 
 namespace {
 constexpr char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
 constexpr int kUninitializedLifetime = -1;
+constexpr int kNoAliasParent = -1;
+
+// Returns true if both tensors hold their values the same way (type and
+// quantization), so the bytes of one are valid bytes of the other.
+bool SameRepresentation(const Tensor* a, const Tensor* b) {
+  if (a->type() != b->type()) {
+    return false;
+  }
+  const QuantizationParameters* qa = a->quantization();
+  const QuantizationParameters* qb = b->quantization();
+  const auto* scale_a = qa != nullptr ? qa->scale() : nullptr;
+  const auto* scale_b = qb != nullptr ? qb->scale() : nullptr;
+  const auto* zero_point_a = qa != nullptr ? qa->zero_point() : nullptr;
+  const auto* zero_point_b = qb != nullptr ? qb->zero_point() : nullptr;
+  const size_t scales = scale_a != nullptr ? scale_a->size() : 0;
+  const size_t zero_points = zero_point_a != nullptr ? zero_point_a->size() : 0;
+
+  if (scales != (scale_b != nullptr ? scale_b->size() : 0) ||
+      zero_points != (zero_point_b != nullptr ? zero_point_b->size() : 0)) {
+    return false;
+  }
+  for (size_t i = 0; i < scales; ++i) {
+    if (scale_a->Get(i) != scale_b->Get(i)) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < zero_points; ++i) {
+    if (zero_point_a->Get(i) != zero_point_b->Get(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsSubgraphInputOrOutput(const SubGraph* subgraph, int tensor_index) {
+  for (size_t i = 0;
+       subgraph->inputs() != nullptr && i < subgraph->inputs()->size(); ++i) {
+    if (subgraph->inputs()->Get(i) == tensor_index) {
+      return true;
+    }
+  }
+  for (size_t i = 0;
+       subgraph->outputs() != nullptr && i < subgraph->outputs()->size(); ++i) {
+    if (subgraph->outputs()->Get(i) == tensor_index) {
+      return true;
+    }
+  }
+  return false;
+}
 }  // namespace
 
 // Mark the given Allocation info as first created at the specified allocation
@@ -198,6 +249,8 @@ TfLiteStatus AllocationInfoBuilder::InitializeAllocationInfo(
 
       current->first_created = kUninitializedLifetime;
       current->last_used = kUninitializedLifetime;
+      current->alias_parent = kNoAliasParent;
+      current->alias_offset = 0;
       current->needs_allocating =
           (eval_tensors[i].data.data == nullptr) &&
           (!subgraph->tensors()->Get(i)->is_variable()) &&
@@ -224,6 +277,8 @@ TfLiteStatus AllocationInfoBuilder::InitializeAllocationInfo(
     AllocationInfo* current = &scratch_allocation_info[i];
     current->first_created = kUninitializedLifetime;
     current->last_used = kUninitializedLifetime;
+    current->alias_parent = kNoAliasParent;
+    current->alias_offset = 0;
     current->needs_allocating = true;
     current->offline_offset = kOnlinePlannedBuffer;
   }
@@ -333,6 +388,109 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
   return kTfLiteOk;
 }
 
+bool AllocationInfoBuilder::TryAlias(const SubGraph* subgraph,
+                                     size_t subgraph_offset, int child,
+                                     int parent, size_t offset) {
+  AllocationInfo* allocation_info = info_.allocation_info;
+  const int child_idx = subgraph_offset + child;
+  const int parent_idx = subgraph_offset + parent;
+  AllocationInfo* child_info = &allocation_info[child_idx];
+  AllocationInfo* parent_info = &allocation_info[parent_idx];
+
+  if (child == parent || !child_info->needs_allocating ||
+      !parent_info->needs_allocating ||
+      child_info->offline_offset != kOnlinePlannedBuffer ||
+      parent_info->offline_offset != kOnlinePlannedBuffer ||
+      child_info->alias_parent != kNoAliasParent ||
+      parent_info->alias_parent != kNoAliasParent ||
+      child_info->first_created == kUninitializedLifetime ||
+      parent_info->first_created == kUninitializedLifetime ||
+      offset % MicroArenaBufferAlignment() != 0 ||
+      offset + child_info->bytes > parent_info->bytes ||
+      IsSubgraphInputOrOutput(subgraph, child) ||
+      !SameRepresentation(subgraph->tensors()->Get(child),
+                          subgraph->tensors()->Get(parent))) {
+    return false;
+  }
+
+  // No chains: a buffer that already holds aliases stays planned.
+  for (size_t i = 0; i < info_.allocation_info_count; ++i) {
+    if (allocation_info[i].alias_parent == child_idx) {
+      return false;
+    }
+  }
+
+  parent_info->first_created =
+      std::min(parent_info->first_created, child_info->first_created);
+  parent_info->last_used =
+      std::max(parent_info->last_used, child_info->last_used);
+  child_info->needs_allocating = false;
+  child_info->alias_parent = parent_idx;
+  child_info->alias_offset = offset;
+  return true;
+}
+
+TfLiteStatus AllocationInfoBuilder::MarkConcatenationAliases(
+    SubgraphAllocations* allocations) {
+#if !EI_TFLITE_DISABLE_CONCATENATION_ALIASING
+  AllocationInfo* allocation_info = info_.allocation_info;
+
+  for (size_t subgraph_idx = 0; subgraph_idx < model_->subgraphs()->size();
+       subgraph_idx++) {
+    const SubGraph* subgraph = model_->subgraphs()->Get(subgraph_idx);
+    const size_t subgraph_offset = info_.subgraph_offsets[subgraph_idx];
+    TfLiteEvalTensor* eval_tensors = allocations[subgraph_idx].tensors;
+    uint32_t operators_size = NumSubgraphOperators(subgraph);
+
+    for (uint32_t i = 0; i < operators_size; i++) {
+      const auto* op = subgraph->operators()->Get(i);
+      const OperatorCode* opcode =
+          model_->operator_codes()->Get(op->opcode_index());
+      const ConcatenationOptions* options =
+          op->builtin_options_as_ConcatenationOptions();
+
+      if (GetBuiltinCode(opcode) != BuiltinOperator_CONCATENATION ||
+          options == nullptr ||
+          options->fused_activation_function() != ActivationFunctionType_NONE ||
+          op->inputs() == nullptr || op->outputs() == nullptr ||
+          op->outputs()->size() != 1) {
+        continue;
+      }
+
+      // Slices are contiguous only when all the dimensions before the axis
+      // are 1.
+      const int output = op->outputs()->Get(0);
+      const TfLiteIntArray* dims = eval_tensors[output].dims;
+      const int axis =
+          options->axis() < 0 ? options->axis() + dims->size : options->axis();
+      int outer_size = 1;
+
+      if (axis < 0 || axis >= dims->size) {
+        continue;
+      }
+      for (int d = 0; d < axis; ++d) {
+        outer_size *= dims->data[d];
+      }
+      if (outer_size != 1) {
+        continue;
+      }
+
+      size_t offset = 0;
+      for (size_t n = 0; n < op->inputs()->size(); ++n) {
+        const int input = op->inputs()->Get(n);
+
+        if (input < 0) {
+          break;
+        }
+        TryAlias(subgraph, subgraph_offset, input, output, offset);
+        offset += allocation_info[subgraph_offset + input].bytes;
+      }
+    }
+  }
+#endif
+  return kTfLiteOk;
+}
+
 // Get offline tensors allocation plan. See
 // micro/docs/memory_management.md for more info.
 TfLiteStatus AllocationInfoBuilder::GetOfflinePlannedOffsets(
@@ -25,6 +25,8 @@ limitations under the License.
 namespace tflite {
 
 // Used to hold information used during allocation calculations.
+// A buffer with alias_parent >= 0 is not planned: it lives at alias_offset
+// bytes into the buffer of allocation_info[alias_parent].
 struct AllocationInfo {
   size_t bytes;
   void** output_ptr;
@@ -32,6 +34,8 @@ struct AllocationInfo {
   int last_used;
   int32_t offline_offset;
   bool needs_allocating;
+  int alias_parent;
+  size_t alias_offset;
 };
 
 // Used to hold the allocation info list and related metadata for the entire
@@ -105,6 +109,16 @@ class AllocationInfoBuilder {
       ScratchBufferHandle* scratch_buffer_handles,
       SubgraphAllocations* allocations);
 
+  // Alias the inputs of CONCATENATION ops into their slice of the output
+  // where the slices are contiguous, so the producers write straight into the
+  // concatenated buffer and the kernel has nothing to copy. Inputs are only
+  // aliased when both buffers are planned online, the input is not a subgraph
+  // input/output, it has the output's type and quantization, and the slice is
+  // aligned. The output's lifetime is extended to cover the aliased inputs.
+  // Must be called after MarkAllocationLifetimes. Define
+  // EI_TFLITE_DISABLE_CONCATENATION_ALIASING=1 to turn it off.
+  TfLiteStatus MarkConcatenationAliases(SubgraphAllocations* allocations);
+
   // Returns the number of allocations.
   int AllocationCount() const { return info_.allocation_info_count; }
 
@@ -124,6 +138,11 @@ class AllocationInfoBuilder {
   // count monotonically increases through the lifetime marking process.
   void UpdateLastUsed(AllocationInfo* current, int allocation_scope_count);
 
+  // Try to alias tensor `child` at `offset` bytes into tensor `parent`, both
+  // tensor indices of `subgraph`. Returns false if it is not safe.
+  bool TryAlias(const SubGraph* subgraph, size_t subgraph_offset, int child,
+                int parent, size_t offset);
+
   // Validate if a subgraph satisfies assumptions.
   TfLiteStatus ValidateSubgraph(const SubGraph* subgraph,
                                 TfLiteEvalTensor* eval_tensors);
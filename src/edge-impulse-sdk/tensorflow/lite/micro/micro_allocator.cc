@@ -109,6 +109,15 @@ TfLiteStatus CommitPlan(MicroMemoryPlanner* planner, uint8_t* starting_point,
       ++planner_index;
     }
   }
+  // Aliased buffers live inside their (planned) parent.
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->alias_parent >= 0) {
+      const AllocationInfo* parent = &allocation_info[current->alias_parent];
+      *current->output_ptr = reinterpret_cast<void*>(
+          static_cast<uint8_t*>(*parent->output_ptr) + current->alias_offset);
+    }
+  }
   return kTfLiteOk;
 }
 
@@ -835,6 +844,7 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
       GetScratchBufferRequests();
   TF_LITE_ENSURE_STATUS(builder.MarkAllocationLifetimes(
       0, scratch_buffer_requests, scratch_buffer_handles, allocations));
+  TF_LITE_ENSURE_STATUS(builder.MarkConcatenationAliases(allocations));
   int allocation_info_count = builder.AllocationCount();
   AllocationInfo* allocation_info = builder.Finish();
 
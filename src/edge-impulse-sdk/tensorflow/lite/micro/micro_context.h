@@ -102,6 +102,11 @@ class MicroContext {
   // housekeeping in MicroContext.
   void SetScratchBufferHandles(ScratchBufferHandle* scratch_buffer_handles);
 
+  // Bytes of persistent arena taken so far by prepacked convolution filters,
+  // kept against EI_TFLITE_CONV_PREPACK_BUDGET by ConvPrepackWeights.
+  size_t conv_prepack_bytes() const { return conv_prepack_bytes_; }
+  void add_conv_prepack_bytes(size_t bytes) { conv_prepack_bytes_ += bytes; }
+
  private:
   // Return the tensor index as tensor_indices[index]. tensor_indices is of
   // max_size. Return -1 if index is not in the valid range of tensor_indices.
@@ -113,6 +118,7 @@ class MicroContext {
 
   ScratchBufferHandle* scratch_buffer_handles_ = nullptr;
   void* external_context_payload_ = nullptr;
+  size_t conv_prepack_bytes_ = 0;
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
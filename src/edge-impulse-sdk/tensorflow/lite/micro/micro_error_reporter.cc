@@ -23,16 +23,16 @@ limitations under the License.
 
 namespace {
 uint8_t micro_error_reporter_buffer[sizeof(tflite::MicroErrorReporter)];
-tflite::MicroErrorReporter* error_reporter_ = nullptr;
 
 }  // namespace
 
 namespace tflite {
 ErrorReporter* GetMicroErrorReporter() {
-  if (error_reporter_ == nullptr) {
-    error_reporter_ = new (micro_error_reporter_buffer) MicroErrorReporter();
-  }
-  return error_reporter_;
+  // Constructed on first use; the local static makes that safe when several
+  // interpreters are set up from different threads.
+  static MicroErrorReporter* error_reporter =
+      new (micro_error_reporter_buffer) MicroErrorReporter();
+  return error_reporter;
 }
 
 int MicroErrorReporter::Report(const char* format, va_list args) {
@@ -21,8 +21,10 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/micro/flatbuffer_utils.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/memory_helpers.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_log.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_op_profiler.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler.h"
 #include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 
 namespace tflite {
 namespace {
@@ -163,6 +165,12 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
   }
   uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
   for (size_t i = 0; i < operators_size; ++i) {
+    // Cancellation point between operators (deadline of the running impulse)
+    if (i > 0 && ei_run_impulse_check_deadline() == EI_IMPULSE_CANCELED) {
+      current_subgraph_index_ = previous_subgraph_idx;
+      return kTfLiteCancelled;
+    }
+
     TfLiteNode* node =
         &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
     const TfLiteRegistration* registration = subgraph_allocations_[subgraph_idx]
@@ -177,6 +185,10 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
         OpNameFromRegistration(registration),
         reinterpret_cast<MicroProfilerInterface*>(context_->profiler));
 #endif
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    ScopedMicroOpProfiler scoped_op_profiler(OpTag(registration),
+                                             GetMicroOpProfiler());
+#endif
 
     TFLITE_DCHECK(registration->invoke);
     TfLiteStatus invoke_status = registration->invoke(context_, node);
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_op_profiler.h"
+
+#include <cstring>
+
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+void MicroOpProfiler::BeginInvoke() {
+  next_op_ = 0;
+  num_invokes_++;
+}
+
+uint32_t MicroOpProfiler::BeginEvent(const char* tag) {
+  if (next_op_ >= kMaxOps) {
+    return kMaxOps;
+  }
+
+  const int op = next_op_++;
+  if (op >= num_ops_) {
+    num_ops_ = op + 1;
+  }
+  tags_[op] = tag;
+  start_ticks_[op] = static_cast<uint32_t>(ei_read_timer_us());
+  return op;
+}
+
+void MicroOpProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle >= static_cast<uint32_t>(kMaxOps)) {
+    return;
+  }
+
+  total_ticks_[event_handle] +=
+      static_cast<uint32_t>(ei_read_timer_us()) - start_ticks_[event_handle];
+}
+
+void MicroOpProfiler::ClearEvents() {
+  for (int i = 0; i < num_ops_; i++) {
+    tags_[i] = nullptr;
+    total_ticks_[i] = 0;
+  }
+  num_ops_ = 0;
+  next_op_ = 0;
+  num_invokes_ = 0;
+}
+
+void MicroOpProfiler::LogTicksPerOpCsv() const {
+  if (num_ops_ == 0) {
+    ei_printf("No operators recorded: the graph runner doesn't time its "
+              "operators\n");
+    return;
+  }
+
+  const uint32_t invokes = num_invokes_ > 0 ? num_invokes_ : 1;
+  uint32_t total_ticks = 0;
+
+  ei_printf("\"Op index\",\"Op type\",\"Average ticks per invoke\"\n");
+  for (int i = 0; i < num_ops_; i++) {
+    ei_printf("%d, %s, %lu\n", i, tags_[i], (unsigned long)(total_ticks_[i] / invokes));
+    total_ticks += total_ticks_[i] / invokes;
+  }
+  ei_printf("total number of ticks, %lu\n", (unsigned long)total_ticks);
+}
+
+void MicroOpProfiler::LogTicksPerTagCsv() const {
+  if (num_ops_ == 0) {
+    ei_printf("No operators recorded: the graph runner doesn't time its "
+              "operators\n");
+    return;
+  }
+
+  const uint32_t invokes = num_invokes_ > 0 ? num_invokes_ : 1;
+  uint32_t total_ticks = 0;
+
+  ei_printf("\"Unique Tag\",\"Total ticks across all events with that tag.\"\n");
+  for (int i = 0; i < num_ops_; i++) {
+    // print each tag once, at its first operator
+    bool seen = false;
+    for (int j = 0; j < i && !seen; j++) {
+      seen = strcmp(tags_[j], tags_[i]) == 0;
+    }
+    if (seen) {
+      continue;
+    }
+
+    uint32_t ticks = 0;
+    for (int j = i; j < num_ops_; j++) {
+      if (strcmp(tags_[j], tags_[i]) == 0) {
+        ticks += total_ticks_[j] / invokes;
+      }
+    }
+    ei_printf("%s, %lu\n", tags_[i], (unsigned long)ticks);
+    total_ticks += ticks;
+  }
+  ei_printf("total number of ticks, %lu\n", (unsigned long)total_ticks);
+}
+
+MicroOpProfiler* GetMicroOpProfiler() {
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+  static MicroOpProfiler profiler;
+  return &profiler;
+#else
+  return nullptr;
+#endif
+}
+
+const char* OpTag(const TfLiteRegistration* registration) {
+  if (registration->builtin_code == BuiltinOperator_CUSTOM &&
+      registration->custom_name != nullptr) {
+    return registration->custom_name;
+  }
+  return EnumNameBuiltinOperator(
+      static_cast<BuiltinOperator>(registration->builtin_code));
+}
+
+}  // namespace tflite
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_OP_PROFILER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_OP_PROFILER_H_
+
+#include <cstdint>
+
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler_interface.h"
+
+// Opt-in: time every operator of the interpreter, and of EON compiled graphs
+// whose generated code wraps each layer with ScopedMicroOpProfiler
+#ifndef EI_CLASSIFIER_PROFILE_OPS
+#define EI_CLASSIFIER_PROFILE_OPS 0
+#endif
+
+#ifndef EI_CLASSIFIER_PROFILE_OPS_MAX
+#define EI_CLASSIFIER_PROFILE_OPS_MAX 128
+#endif
+
+namespace tflite {
+
+// Ticks per operator index, accumulated over every profiled invoke.
+// MicroProfiler is compiled out together with the error strings and has no
+// tick source on most targets, and EON compiled graphs don't go through
+// MicroGraph, so this one reads ei_read_timer_us() (ticks are microseconds)
+// and is driven by the graph runner: BeginInvoke() before running the graph,
+// then one event per operator, in execution order.
+class MicroOpProfiler : public MicroProfilerInterface {
+ public:
+  MicroOpProfiler() = default;
+  virtual ~MicroOpProfiler() = default;
+
+  // Marks the start of an invoke, the next event is operator 0.
+  void BeginInvoke();
+
+  // Marks the start of the next operator and returns its index.
+  virtual uint32_t BeginEvent(const char* tag) override;
+
+  // Marks the end of the operator returned by BeginEvent.
+  virtual void EndEvent(uint32_t event_handle) override;
+
+  // Clears all operators and invokes.
+  void ClearEvents();
+
+  // Prints the average ticks per invoke of each operator index in CSV form.
+  void LogTicksPerOpCsv() const;
+
+  // Prints the average ticks per invoke of each unique tag, in the same CSV
+  // form as MicroProfiler::LogTicksPerTagCsv.
+  void LogTicksPerTagCsv() const;
+
+ private:
+  static constexpr int kMaxOps = EI_CLASSIFIER_PROFILE_OPS_MAX;
+
+  const char* tags_[kMaxOps] = {};
+  uint32_t start_ticks_[kMaxOps] = {};
+  uint32_t total_ticks_[kMaxOps] = {};
+  int num_ops_ = 0;
+  int next_op_ = 0;
+  uint32_t num_invokes_ = 0;
+};
+
+// Profiler shared by the interpreter and compiled graphs, nullptr unless
+// EI_CLASSIFIER_PROFILE_OPS is 1.
+MicroOpProfiler* GetMicroOpProfiler();
+
+// Name of the operator a registration implements (builtin or custom).
+const char* OpTag(const TfLiteRegistration* registration);
+
+// Times one operator for the lifetime of the object, does nothing without a
+// profiler. Compiled graphs are only timed if their generated code wraps each
+// layer with:
+//   ScopedMicroOpProfiler scoped_op_profiler(OpTag(registration), GetMicroOpProfiler());
+class ScopedMicroOpProfiler {
+ public:
+  explicit ScopedMicroOpProfiler(const char* tag, MicroOpProfiler* profiler)
+      : profiler_(profiler) {
+    if (profiler_ != nullptr) {
+      event_handle_ = profiler_->BeginEvent(tag);
+    }
+  }
+
+  ~ScopedMicroOpProfiler() {
+    if (profiler_ != nullptr) {
+      profiler_->EndEvent(event_handle_);
+    }
+  }
+
+ private:
+  uint32_t event_handle_ = 0;
+  MicroOpProfiler* profiler_ = nullptr;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_OP_PROFILER_H_
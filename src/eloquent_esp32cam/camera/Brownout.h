@@ -2,8 +2,10 @@
 #define ELOQUENT_ESP32CAM_CAMERA_BROWNOUT
 
 
+#if defined(ESP_PLATFORM)
 #include "soc/soc.h"
 #include "soc/rtc_cntl_reg.h"
+#endif
 
 
 namespace Eloquent {
@@ -17,16 +19,21 @@ namespace Eloquent {
             public:
                 /**
                  * Disable detector
+                 * (no-op on the host)
                  */
                 void disable() {
+#if defined(ESP_PLATFORM)
                     WRITE_PERI_REG(RTC_CNTL_BROWN_OUT_REG, 0);
+#endif
                 }
 
                 /**
                  * Enable detector
                  */
                 void enable() {
+#if defined(ESP_PLATFORM)
                     WRITE_PERI_REG(RTC_CNTL_BROWN_OUT_REG, 1);
+#endif
                 }
             };
         }
@@ -1,7 +1,8 @@
 #ifndef ELOQUENT_ESP32CAM_CAMERA_RESOLUTION
 #define ELOQUENT_ESP32CAM_CAMERA_RESOLUTION
 
-#include <esp_camera.h>
+#include "./driver.h"
+#include "../extra/log.h"
 #include "../extra/time/benchmark.h"
 
 using Eloquent::Extra::Time::Benchmark;
@@ -1,7 +1,7 @@
 #ifndef ELOQUENT_ESP32CAM_CAMERA_SENSOR
 #define ELOQUENT_ESP32CAM_CAMERA_SENSOR
 
-#include <esp_camera.h>
+#include "./driver.h"
 
 
 namespace Eloquent {
@@ -1,14 +1,15 @@
 #ifndef ELOQUENT_ESP32CAMERA_CAMERA_CAMERA
 #define ELOQUENT_ESP32CAMERA_CAMERA_CAMERA
 
-#include <esp_camera.h>
-#include <esp_log.h>
-#include "./brownout.h"
-#include "./xclk.h"
-#include "./resolution.h"
-#include "./sensor.h"
+#include "./driver.h"
+#include "../extra/log.h"
+#include "./Brownout.h"
+#include "./XCLK.h"
+#include "./Resolution.h"
+#include "./Sensor.h"
 #include "./pixformat.h"
 #include "./rgb_565.h"
+#include "./frame_lease.h"
 #include "../extra/exception.h"
 #include "../extra/time/rate_limit.h"
 #include "../extra/esp32/multiprocessing/mutex.h"
@@ -90,15 +91,23 @@ namespace Eloquent {
                 }
 
                 /**
-                 * Capture new frame
+                 * Capture new frame.
+                 * The previous frame goes back to the driver once nobody leases it anymore
                  */
                 Exception &capture() {
                     if (!rateLimit)
                         return exception.soft().set("Too many requests for frame");
 
-                    mutex.threadsafe([this]() {
-                        free();
-                        frame = esp_camera_fb_get();
+                    // with a single buffer, the previous frame must be returned first
+                    if (config.fb_count < 2)
+                        mutex.threadsafe([this]() { free(); }, 1000);
+
+                    // grab outside the mutex, so leasers are not blocked while the sensor fills the buffer
+                    FrameLease next = FrameLease::capture();
+
+                    mutex.threadsafe([this, &next]() {
+                        _lease = std::move(next);
+                        frame = _lease.get();
                     }, 1000);
 
                     if (!mutex.isOk())
@@ -112,14 +121,28 @@ namespace Eloquent {
                     return exception.clear();
                 }
 
+                /**
+                 * Share the current frame: it stays valid, even after the
+                 * next capture(), until the returned lease is released.
+                 * The mutex is only held to copy the lease
+                 */
+                FrameLease lease() {
+                    FrameLease current;
+
+                    mutex.threadsafe([this, &current]() {
+                        current = _lease;
+                    }, 1000);
+
+                    return current;
+                }
+
                 /**
                  * Release frame memory
+                 * (the buffer goes back to the driver once nobody leases it anymore)
                  */
                 void free() {
-                    if (frame != NULL) {
-                        esp_camera_fb_return(frame);
-                        frame = NULL;
-                    }
+                    _lease.release();
+                    frame = NULL;
                 }
 
                 /**
@@ -167,6 +190,7 @@ namespace Eloquent {
                 }
 
             protected:
+                FrameLease _lease;
             };
         }
     }
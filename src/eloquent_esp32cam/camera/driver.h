@@ -0,0 +1,12 @@
+#ifndef ELOQUENT_ESP32CAM_CAMERA_DRIVER
+#define ELOQUENT_ESP32CAM_CAMERA_DRIVER
+
+// esp32-camera on the ESP32, simulated camera on the host (see extra/host/esp_camera.h)
+#if defined(ESP_PLATFORM)
+#include <esp_camera.h>
+#include <img_converters.h>
+#else
+#include "../extra/host/esp_camera.h"
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef ELOQUENT_ESP32CAM_CAMERA_FRAME_LEASE
+#define ELOQUENT_ESP32CAM_CAMERA_FRAME_LEASE
+
+#include <stdint.h>
+#include <atomic>
+#include "./driver.h"
+#include "../extra/log.h"
+
+// at least the camera fb_count
+#ifndef ELOQUENT_CAMERA_MAX_LEASED_FRAMES
+#define ELOQUENT_CAMERA_MAX_LEASED_FRAMES 4
+#endif
+
+namespace Eloquent {
+    namespace Esp32cam {
+        namespace Camera {
+            /**
+             * Shared ownership of a camera frame buffer, without copying it.
+             * Every copy of a lease keeps the buffer alive, the buffer goes
+             * back to the driver when the last copy is released.
+             * Like std::shared_ptr, a single lease must not be modified by
+             * two tasks at once, distinct copies can live on distinct tasks.
+             * Bookkeeping uses a fixed pool, no heap allocation
+             */
+            class FrameLease {
+            public:
+                /**
+                 * Empty lease
+                 */
+                FrameLease() :
+                    _lease(nullptr) {
+                }
+
+                /**
+                 * Share the frame
+                 */
+                FrameLease(const FrameLease &other) :
+                    _lease(other._lease) {
+                    if (_lease != nullptr)
+                        _lease->refs.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                /**
+                 * Take over the frame
+                 */
+                FrameLease(FrameLease &&other) :
+                    _lease(other._lease) {
+                    other._lease = nullptr;
+                }
+
+                /**
+                 * Destructor
+                 */
+                ~FrameLease() {
+                    release();
+                }
+
+                /**
+                 * Share the frame
+                 */
+                FrameLease& operator=(const FrameLease &other) {
+                    if (other._lease != nullptr)
+                        other._lease->refs.fetch_add(1, std::memory_order_relaxed);
+
+                    release();
+                    _lease = other._lease;
+
+                    return *this;
+                }
+
+                /**
+                 * Take over the frame
+                 */
+                FrameLease& operator=(FrameLease &&other) {
+                    if (this != &other) {
+                        release();
+                        _lease = other._lease;
+                        other._lease = nullptr;
+                    }
+
+                    return *this;
+                }
+
+                /**
+                 * Lease a frame returned by esp_camera_fb_get().
+                 * If the pool is exhausted, the frame is given back and the lease is empty
+                 */
+                static FrameLease adopt(camera_fb_t *frame) {
+                    FrameLease lease;
+
+                    if (frame == nullptr)
+                        return lease;
+
+                    for (uint8_t i = 0; i < ELOQUENT_CAMERA_MAX_LEASED_FRAMES; i++) {
+                        Lease &candidate = pool()[i];
+                        camera_fb_t *empty = nullptr;
+
+                        if (candidate.frame.compare_exchange_strong(empty, frame, std::memory_order_acquire)) {
+                            candidate.refs.store(1, std::memory_order_relaxed);
+                            lease._lease = &candidate;
+
+                            return lease;
+                        }
+                    }
+
+                    ESP_LOGE("FrameLease", "More than %d frames leased, raise ELOQUENT_CAMERA_MAX_LEASED_FRAMES", ELOQUENT_CAMERA_MAX_LEASED_FRAMES);
+                    esp_camera_fb_return(frame);
+
+                    return lease;
+                }
+
+                /**
+                 * Capture a new frame from the driver
+                 */
+                static FrameLease capture() {
+                    return adopt(esp_camera_fb_get());
+                }
+
+                /**
+                 * Drop this lease (the buffer goes back to the driver if it was the last one)
+                 */
+                void release() {
+                    Lease *lease = _lease;
+
+                    _lease = nullptr;
+
+                    if (lease == nullptr || lease->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                        return;
+
+                    esp_camera_fb_return(lease->frame.load(std::memory_order_relaxed));
+                    lease->frame.store(nullptr, std::memory_order_release);
+                }
+
+                /**
+                 * Get frame (nullptr if empty)
+                 */
+                camera_fb_t* get() const {
+                    return _lease != nullptr ? _lease->frame.load(std::memory_order_relaxed) : nullptr;
+                }
+
+                /**
+                 * Access frame fields
+                 */
+                camera_fb_t* operator->() const {
+                    return get();
+                }
+
+                /**
+                 * Test if lease holds a frame
+                 */
+                explicit operator bool() const {
+                    return _lease != nullptr;
+                }
+
+                /**
+                 * Get number of leases sharing the frame
+                 */
+                uint8_t useCount() const {
+                    return _lease != nullptr ? _lease->refs.load(std::memory_order_relaxed) : 0;
+                }
+
+            protected:
+                struct Lease {
+                    std::atomic<camera_fb_t*> frame;
+                    std::atomic<uint8_t> refs;
+                };
+
+                Lease *_lease;
+
+                /**
+                 * Leases of all frames currently out of the driver
+                 */
+                static Lease* pool() {
+                    static Lease leases[ELOQUENT_CAMERA_MAX_LEASED_FRAMES] = {};
+
+                    return leases;
+                }
+            };
+        }
+    }
+}
+
+#endif
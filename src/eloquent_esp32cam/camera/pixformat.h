@@ -1,7 +1,7 @@
 #ifndef ELOQUENT_ESP32CAM_CAMERA_PIXFORMAT_H
 #define ELOQUENT_ESP32CAM_CAMERA_PIXFORMAT_H
 
-#include <esp_camera.h>
+#include "./driver.h"
 
 
 namespace Eloquent {
@@ -2,6 +2,7 @@
 #define ELOQUENT_ESP32CAM_CAMERA_CONVERTER
 
 #include "../extra/exception.h"
+#include "../extra/log.h"
 
 using Eloquent::Error::Exception;
 
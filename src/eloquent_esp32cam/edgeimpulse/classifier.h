@@ -45,6 +45,25 @@ namespace Eloquent {
                     _isDebugEnabled = enabled;
                 }
 
+                /**
+                 * Keep the model graph initialized between runs
+                 * (disable to release the arena)
+                 */
+                void resident(bool enabled = true) {
+                    if (enabled)
+                        run_classifier_resident_init();
+                    else
+                        run_classifier_resident_deinit();
+                }
+
+                /**
+                 * Abort runs that take longer than the given budget
+                 * (error is EI_IMPULSE_CANCELED, 0 = no deadline)
+                 */
+                void deadline(uint32_t micros) {
+                    run_classifier_set_deadline(micros);
+                }
+
                 /**
                  * Run the classification
                  */
@@ -56,6 +75,9 @@ namespace Eloquent {
                         error = run_classifier(&signal, &result, _isDebugEnabled);
                     });
 
+                    if (error == EI_IMPULSE_CANCELED)
+                        return exception.set("Deadline exceeded");
+
                     if (error != EI_IMPULSE_OK)
                         return exception.set("Classification error");
 
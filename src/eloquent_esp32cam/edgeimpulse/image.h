@@ -1,15 +1,18 @@
 #ifndef ELOQUENT_ESP32CAM_EDGEIMPULSE_IMAGE_H
 #define ELOQUENT_ESP32CAM_EDGEIMPULSE_IMAGE_H
 
-#include <esp_camera.h>
+#include "../camera/driver.h"
 #include <edge-impulse-sdk/dsp/image/image.hpp>
 #include "../extra/pubsub.h"
 #include "./classifier.h"
+#include "./resampler.h"
 #include <string>
+#include <algorithm>
 
 using namespace eloq;
 using ei::signal_t;
 using eloq::camera;
+using Eloquent::Esp32cam::Camera::FrameLease;
 #if defined(ELOQUENT_EXTRA_PUBSUB_H)
 using Eloquent::Extra::PubSub;
 #endif
@@ -33,6 +36,7 @@ namespace Eloquent
                 float proba;
                 size_t srcWidth;
                 size_t srcHeight;
+                Resampler<EI_CLASSIFIER_INPUT_WIDTH, EI_CLASSIFIER_INPUT_HEIGHT> resampler;
 #if defined(ELOQUENT_EXTRA_PUBSUB_H)
                 PubSub<ImageClassifier> mqtt;
 #endif
@@ -47,30 +51,48 @@ namespace Eloquent
 #if defined(ELOQUENT_EXTRA_PUBSUB_H)
                                     mqtt(this),
 #endif
+                                    _frame(NULL),
                                     _buf(NULL),
                                     _len(0)
                 {
                 }
 
                 /**
-                 * Detect object from camera frame
+                 * Detect object from camera frame.
+                 * The frame is leased, so the camera can keep capturing
+                 * into its other buffers while the model runs
                  */
                 virtual Exception &run()
                 {
-                    // run EI model
-                    benchmark.benchmark([this]()
-                                        { camera.mutex.threadsafe([this]()
-                                                                  {
+                    FrameLease frame = camera.lease();
+
+                    if (!camera.mutex.isOk())
+                        return exception.set("Cannot acquire mutex for camera frame");
+
+                    return run(frame.get());
+                }
+
+                /**
+                 * Detect object from a frame owned by the caller
+                 * (e.g. handed over by a capture task).
+                 * The camera mutex is not needed
+                 */
+                Exception &run(camera_fb_t *frame)
+                {
+                    benchmark.benchmark([this, frame]()
+                                        {
+                                _frame = frame;
+
                                 if (!beforeClassification())
                                     return;
 
-                                error = run_classifier(&signal, &result, _isDebugEnabled); }); });
+                                error = run_classifier(&signal, &result, _isDebugEnabled); });
 
                     if (!exception.isOk())
                         return exception;
 
-                    if (!camera.mutex.isOk())
-                        return exception.set("Cannot acquire mutex for camera frame");
+                    if (error == EI_IMPULSE_CANCELED)
+                        return exception.set("Deadline exceeded");
 
                     if (error != EI_IMPULSE_OK)
                         return exception.set(std::string(" "));
@@ -98,36 +120,24 @@ namespace Eloquent
                 }
 
             protected:
+                camera_fb_t *_frame;
                 uint8_t *_buf;
                 size_t _len;
-                float _dx;
-                float _dy;
 
                 /**
                  *
                  */
                 bool beforeClassification()
                 {
-                    if (!camera.hasFrame())
+                    if (_frame == NULL || _frame->len == 0)
                         return exception.set("Cannot run EI model on empty frame").isOk();
 
-                    _buf = camera.frame->buf;
-                    _len = camera.frame->len;
-                    srcWidth = camera.resolution.getWidth();
-                    srcHeight = camera.resolution.getHeight();
-
-                    // rgb 565 bytes are swapped!
-                    for (int i = 0; i < _len; i += 2)
-                    {
-                        const uint8_t a = _buf[i];
-                        const uint8_t b = _buf[i + 1];
-
-                        _buf[i] = b;
-                        _buf[i + 1] = a;
-                    }
+                    _buf = _frame->buf;
+                    _len = _frame->len;
+                    srcWidth = _frame->width;
+                    srcHeight = _frame->height;
 
-                    _dx = ((float)srcWidth) / EI_CLASSIFIER_INPUT_WIDTH;
-                    _dy = ((float)srcHeight) / EI_CLASSIFIER_INPUT_HEIGHT;
+                    resampler.update(srcWidth, srcHeight);
 
                     signal.get_data = [this](size_t offset, size_t length, float *out)
                     {
@@ -161,50 +171,18 @@ namespace Eloquent
                  */
                 int getData(size_t offset, size_t length, float *out)
                 {
-                    size_t i = 0;
-                    const size_t end = std::min((int)EI_CLASSIFIER_RAW_SAMPLE_COUNT, (int)(offset + length));
-
-                    for (uint16_t y = 0; y < EI_CLASSIFIER_INPUT_HEIGHT; y++)
+                    resampler.sample(_buf, offset, length, [out](size_t i, uint8_t r, uint8_t g, uint8_t b)
                     {
-                        const size_t offsetY = ((size_t)(y * _dy)) * srcWidth;
-
-                        for (uint16_t x = 0; x < EI_CLASSIFIER_INPUT_WIDTH; x++, i++)
-                        {
-                            if (i < offset)
-                                continue;
-
-                            if (i >= end)
-                                return 0;
-
-                            const size_t j = offsetY + (x * _dx);
-                            const uint16_t pixel = ((uint16_t *)_buf)[j];
-                            uint32_t r;
-                            uint16_t g;
-                            uint8_t b;
-
-                            toRGB(pixel, &r, &g, &b);
-
 #if _EI_RGB_
-                            out[i - offset] = (r << 16) | (g << 8) | b;
+                        out[i] = (r << 16) | (g << 8) | b;
 #else
-                            const uint32_t gray = std::constrain((r * 38 + g * 75 + b * 15) >> 7, 0, 255);
-                            out[i - offset] = (gray << 16) | (gray << 8) | gray;
+                        const uint32_t gray = std::min((r * 38 + g * 75 + b * 15) >> 7, 255);
+                        out[i] = (gray << 16) | (gray << 8) | gray;
 #endif
-                        }
-                    }
+                    });
 
                     return 0;
                 }
-
-                /**
-                 * Convert high/low RGB565 bytes to R, G, B
-                 */
-                void toRGB(const uint16_t pixel, uint32_t *r, uint16_t *g, uint8_t *b)
-                {
-                    *r = (pixel >> 8) & 0b11111000;
-                    *g = (pixel & 0b11111100000) >> 3;
-                    *b = (pixel & 0b11111) << 3;
-                }
             };
         }
     }
@@ -0,0 +1,204 @@
+#ifndef ELOQUENT_ESP32CAM_EDGEIMPULSE_MOTION_GATE_H
+#define ELOQUENT_ESP32CAM_EDGEIMPULSE_MOTION_GATE_H
+
+#include "../camera/driver.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Eloquent
+{
+    namespace Esp32cam
+    {
+        namespace EdgeImpulse
+        {
+            /**
+             * Skip inference on static scenes.
+             * Every frame is reduced to a tiny luma thumbnail and compared
+             * (mean absolute difference) to the thumbnail of the last frame
+             * that went through the model. Small changes don't reset the
+             * reference, so slow drifts still add up and trigger a run
+             */
+            template <uint8_t thumbWidth = 16, uint8_t thumbHeight = 12>
+            class MotionGate
+            {
+            public:
+                /**
+                 *
+                 */
+                MotionGate() :
+                    _threshold(8),
+                    _maxSkips(5),
+                    _skipsInARow(0),
+                    _skipped(0),
+                    _ran(0),
+                    _score(0),
+                    _hasReference(false),
+                    _enabled(true)
+                {
+                }
+
+                /**
+                 * Set mean luma difference (0-255) that counts as motion
+                 */
+                MotionGate &threshold(uint8_t threshold)
+                {
+                    _threshold = threshold;
+
+                    return *this;
+                }
+
+                /**
+                 * Set how many frames in a row can reuse the last result
+                 * (0 = always run)
+                 */
+                MotionGate &maxSkips(uint16_t maxSkips)
+                {
+                    _maxSkips = maxSkips;
+
+                    return *this;
+                }
+
+                /**
+                 * Enable or disable gating
+                 */
+                MotionGate &enable(bool enabled = true)
+                {
+                    _enabled = enabled;
+                    _hasReference = false;
+
+                    return *this;
+                }
+
+                /**
+                 * Test if the model should run on the given RGB565 frame.
+                 * When false, the previous result is still valid
+                 */
+                bool shouldRun(const camera_fb_t *frame)
+                {
+                    if (!_enabled || frame == NULL || frame->len == 0)
+                        return run(false);
+
+                    thumbnail(frame->buf, frame->width, frame->height, _current);
+
+                    if (!_hasReference || _skipsInARow >= _maxSkips)
+                        return run(true);
+
+                    uint32_t sad = 0;
+
+                    for (uint16_t i = 0; i < thumbWidth * thumbHeight; i++)
+                        sad += _current[i] > _reference[i] ? _current[i] - _reference[i] : _reference[i] - _current[i];
+
+                    _score = sad / (thumbWidth * thumbHeight);
+
+                    if (_score >= _threshold)
+                        return run(true);
+
+                    _skipsInARow++;
+                    _skipped++;
+
+                    return false;
+                }
+
+                /**
+                 * Get mean luma difference of the last frame
+                 */
+                uint8_t score() const
+                {
+                    return _score;
+                }
+
+                /**
+                 * Get number of frames that reused the last result
+                 */
+                uint32_t skipped() const
+                {
+                    return _skipped;
+                }
+
+                /**
+                 * Get number of frames that went through the model
+                 */
+                uint32_t ran() const
+                {
+                    return _ran;
+                }
+
+            protected:
+                uint8_t _threshold;
+                uint16_t _maxSkips;
+                uint16_t _skipsInARow;
+                uint32_t _skipped;
+                uint32_t _ran;
+                uint8_t _score;
+                bool _hasReference;
+                bool _enabled;
+                uint8_t _current[thumbWidth * thumbHeight];
+                uint8_t _reference[thumbWidth * thumbHeight];
+
+                /**
+                 * Let the frame through, optionally making it the new reference
+                 */
+                bool run(bool updateReference)
+                {
+                    if (updateReference)
+                    {
+                        for (uint16_t i = 0; i < thumbWidth * thumbHeight; i++)
+                            _reference[i] = _current[i];
+
+                        _hasReference = true;
+                    }
+
+                    _skipsInARow = 0;
+                    _ran++;
+
+                    return true;
+                }
+
+                /**
+                 * Average luma of each thumbnail cell,
+                 * sampling about 4x4 pixels per cell
+                 */
+                static void thumbnail(const uint8_t *buf, const uint16_t width, const uint16_t height, uint8_t *thumb)
+                {
+                    const uint16_t cellWidth = width / thumbWidth > 0 ? width / thumbWidth : 1;
+                    const uint16_t cellHeight = height / thumbHeight > 0 ? height / thumbHeight : 1;
+                    const uint16_t stepX = cellWidth > 4 ? cellWidth / 4 : 1;
+                    const uint16_t stepY = cellHeight > 4 ? cellHeight / 4 : 1;
+
+                    for (uint8_t ty = 0; ty < thumbHeight; ty++)
+                    {
+                        const uint16_t y0 = ((uint32_t) ty * height) / thumbHeight;
+
+                        for (uint8_t tx = 0; tx < thumbWidth; tx++)
+                        {
+                            const uint16_t x0 = ((uint32_t) tx * width) / thumbWidth;
+                            uint32_t sum = 0;
+                            uint16_t count = 0;
+
+                            for (uint16_t y = y0; y < y0 + cellHeight && y < height; y += stepY)
+                            {
+                                const uint8_t *row = buf + (((size_t) y * width) << 1);
+
+                                for (uint16_t x = x0; x < x0 + cellWidth && x < width; x += stepX)
+                                {
+                                    // RGB565, big endian
+                                    const uint16_t pixel = (((uint16_t) row[x << 1]) << 8) | row[(x << 1) + 1];
+                                    const uint16_t r = (pixel >> 8) & 0b11111000;
+                                    const uint16_t g = (pixel & 0b11111100000) >> 3;
+                                    const uint16_t b = (pixel & 0b11111) << 3;
+
+                                    sum += (r * 38 + g * 75 + b * 15) >> 7;
+                                    count++;
+                                }
+                            }
+
+                            thumb[ty * thumbWidth + tx] = count > 0 ? sum / count : 0;
+                        }
+                    }
+                }
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef ELOQUENT_ESP32CAM_EDGEIMPULSE_RESAMPLER_H
+#define ELOQUENT_ESP32CAM_EDGEIMPULSE_RESAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Eloquent
+{
+    namespace Esp32cam
+    {
+        namespace EdgeImpulse
+        {
+            /**
+             * Resample a RGB565 frame to the model input size.
+             * Row/column lookup tables are built once per source
+             * resolution, so every pixel costs integer lookups only
+             * and any offset can be read in O(1)
+             */
+            template <uint16_t dstWidth, uint16_t dstHeight>
+            class Resampler
+            {
+            public:
+                /**
+                 *
+                 */
+                Resampler() :
+                    _srcWidth(0),
+                    _srcHeight(0),
+                    _smooth(false)
+                {
+                }
+
+                /**
+                 * Enable or disable bilinear interpolation
+                 * (nearest neighbor otherwise)
+                 */
+                void smooth(bool enabled = true)
+                {
+                    if (enabled != _smooth)
+                    {
+                        _smooth = enabled;
+                        _srcWidth = 0;
+                    }
+                }
+
+                /**
+                 * Rebuild the lookup tables if the source resolution changed
+                 */
+                void update(const uint16_t srcWidth, const uint16_t srcHeight)
+                {
+                    if (srcWidth == _srcWidth && srcHeight == _srcHeight)
+                        return;
+
+                    _srcWidth = srcWidth;
+                    _srcHeight = srcHeight;
+
+                    buildAxis(srcWidth, dstWidth, _cols, _colsNext, _colsWeight, 1);
+                    buildAxis(srcHeight, dstHeight, _rows, _rowsNext, _rowsWeight, srcWidth);
+                }
+
+                /**
+                 * Sample `length` output pixels starting at `offset`.
+                 * Callback receives (index from offset, r, g, b)
+                 */
+                template <typename Callback>
+                void sample(const uint8_t *buf, size_t offset, size_t length, Callback callback) const
+                {
+                    const size_t total = (size_t) dstWidth * dstHeight;
+                    const size_t end = offset + length > total ? total : offset + length;
+                    uint16_t y = offset / dstWidth;
+                    uint16_t x = offset % dstWidth;
+
+                    for (size_t i = offset; i < end; i++)
+                    {
+                        uint8_t r, g, b;
+
+                        if (_smooth)
+                            interpolate(buf, x, y, &r, &g, &b);
+                        else
+                            toRGB(pixelAt(buf, _rows[y] + _cols[x]), &r, &g, &b);
+
+                        callback(i - offset, r, g, b);
+
+                        if (++x == dstWidth)
+                        {
+                            x = 0;
+                            y++;
+                        }
+                    }
+                }
+
+            protected:
+                uint16_t _srcWidth;
+                uint16_t _srcHeight;
+                bool _smooth;
+                // source index of each output column / row (row already multiplied by source width)
+                uint32_t _cols[dstWidth];
+                uint32_t _rows[dstHeight];
+                // bilinear mode: offset of the next column / row and its weight (out of 256)
+                uint32_t _colsNext[dstWidth];
+                uint32_t _rowsNext[dstHeight];
+                uint16_t _colsWeight[dstWidth];
+                uint16_t _rowsWeight[dstHeight];
+
+                /**
+                 * Fill the lookup table of a single axis
+                 * (bilinear positions use 16.16 fixed point)
+                 */
+                void buildAxis(const uint16_t src, const uint16_t dst, uint32_t *index, uint32_t *next, uint16_t *weight, const uint32_t stride)
+                {
+                    const uint32_t step = (((uint32_t) src) << 16) / dst;
+
+                    for (uint16_t i = 0; i < dst; i++)
+                    {
+                        if (!_smooth)
+                        {
+                            index[i] = (((uint32_t) i) * src / dst) * stride;
+                            next[i] = 0;
+                            weight[i] = 0;
+                            continue;
+                        }
+
+                        // sample at the center of the destination pixel
+                        int32_t pos = (int32_t) ((i * step) + (step >> 1)) - (1 << 15);
+
+                        if (pos < 0)
+                            pos = 0;
+
+                        uint32_t lo = pos >> 16;
+                        uint32_t hi = lo + 1 < src ? lo + 1 : src - 1;
+
+                        index[i] = lo * stride;
+                        next[i] = (hi - lo) * stride;
+                        weight[i] = (pos & 0xFFFF) >> 8;
+                    }
+                }
+
+                /**
+                 * Bilinear interpolation of the 4 source pixels around (x, y)
+                 */
+                void interpolate(const uint8_t *buf, const uint16_t x, const uint16_t y, uint8_t *r, uint8_t *g, uint8_t *b) const
+                {
+                    const size_t j = _rows[y] + _cols[x];
+                    const uint32_t wx = _colsWeight[x];
+                    const uint32_t wy = _rowsWeight[y];
+                    const uint32_t w00 = (256 - wx) * (256 - wy);
+                    const uint32_t w01 = wx * (256 - wy);
+                    const uint32_t w10 = (256 - wx) * wy;
+                    const uint32_t w11 = wx * wy;
+                    uint8_t r00, g00, b00, r01, g01, b01, r10, g10, b10, r11, g11, b11;
+
+                    toRGB(pixelAt(buf, j), &r00, &g00, &b00);
+                    toRGB(pixelAt(buf, j + _colsNext[x]), &r01, &g01, &b01);
+                    toRGB(pixelAt(buf, j + _rowsNext[y]), &r10, &g10, &b10);
+                    toRGB(pixelAt(buf, j + _rowsNext[y] + _colsNext[x]), &r11, &g11, &b11);
+
+                    *r = (r00 * w00 + r01 * w01 + r10 * w10 + r11 * w11) >> 16;
+                    *g = (g00 * w00 + g01 * w01 + g10 * w10 + g11 * w11) >> 16;
+                    *b = (b00 * w00 + b01 * w01 + b10 * w10 + b11 * w11) >> 16;
+                }
+
+                /**
+                 * Read the RGB565 pixel at the given index.
+                 * Camera frames are big endian, so the bytes are
+                 * swapped while reading instead of in the frame itself
+                 */
+                static inline uint16_t pixelAt(const uint8_t *buf, const size_t j)
+                {
+                    const uint8_t *bytes = buf + (j << 1);
+
+                    return (((uint16_t) bytes[0]) << 8) | bytes[1];
+                }
+
+                /**
+                 * Convert high/low RGB565 bytes to R, G, B
+                 */
+                static inline void toRGB(const uint16_t pixel, uint8_t *r, uint8_t *g, uint8_t *b)
+                {
+                    *r = (pixel >> 8) & 0b11111000;
+                    *g = (pixel & 0b11111100000) >> 3;
+                    *b = (pixel & 0b11111) << 3;
+                }
+            };
+        }
+    }
+}
+
+#endif
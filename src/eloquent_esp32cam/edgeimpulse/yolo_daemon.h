@@ -1,13 +1,13 @@
 #ifndef ELOQUENT_ESP32CAM_EDGEIMPULSE_yolo_DAEMON_H
 #define ELOQUENT_ESP32CAM_EDGEIMPULSE_yolo_DAEMON_H
 
+#include <atomic>
 #include <functional>
 #include "../camera/camera.h"
 #include "../extra/esp32/multiprocessing/thread.h"
+#include "../extra/log.h"
 #include "./bbox.h"
 
-#include "esp_log.h" // Include ESP-IDF logging library
-
 using eloq::camera;
 using eloq::ei::bbox_t;
 using Eloquent::Extra::Esp32::Multiprocessing::Thread;
@@ -31,7 +31,8 @@ namespace Eloquent {
                 yoloDaemon(T *yolo) :
                     thread("yolo"),
                     _yolo(yolo),
-                    _numListeners(0) {
+                    _numListeners(0),
+                    _running(false) {
                 }
 
                 /**
@@ -68,17 +69,24 @@ namespace Eloquent {
                  * Start yolo in background
                  */
                 void start() {
+                    _running = true;
+
                     thread
                         .withArgs((void*) this)
                         .withStackSize(6000)
                         .withPriority(17) // Adjust priority as needed
+#if defined(ESP_PLATFORM)
+                        .onCore(portNUM_PROCESSORS - 1) // keep off the WiFi / system core
+#else
+                        .onAnyCore()
+#endif
                         .run([](void *args) {
                             yoloDaemon *self = (yoloDaemon*) args;
 
-                            vTaskDelay(3000 / portTICK_PERIOD_MS); // Use vTaskDelay instead of delay
+                            Thread::sleep(3000);
 
-                            while (true) {
-                                vTaskDelay(1); // Use vTaskDelay instead of delay
+                            while (self->_running) {
+                                Thread::sleep(1);
 
                                 if (!camera.capture().isOk())
                                     continue;
@@ -106,9 +114,18 @@ namespace Eloquent {
                         });
                 }
 
+                /**
+                 * Stop the background task and wait for it to exit
+                 */
+                void stop() {
+                    _running = false;
+                    thread.join();
+                }
+
             protected:
                 T *_yolo;
                 uint8_t _numListeners;
+                std::atomic<bool> _running;
                 OnNothingCallback _onNothing;
                 struct {
                     std::string label;
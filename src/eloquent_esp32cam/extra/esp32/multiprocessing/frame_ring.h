@@ -0,0 +1,117 @@
+#ifndef ELOQUENT_EXTRA_ESP32_MULTIPROCESSING_FRAME_RING
+#define ELOQUENT_EXTRA_ESP32_MULTIPROCESSING_FRAME_RING
+
+#include <stdint.h>
+#include <atomic>
+
+namespace Eloquent {
+    namespace Extra {
+        namespace Esp32 {
+            namespace Multiprocessing {
+                /**
+                 * Lock-free single producer / single consumer ring of frames
+                 * where the newest frame always wins: when the ring is full
+                 * the producer drops the oldest frame, the consumer always
+                 * gets the latest frame and drops the ones it skipped.
+                 * Dropped frames are handed to a recycle callback
+                 * (e.g. to give the buffer back to the camera driver)
+                 */
+                template<typename T, uint8_t capacity = 1>
+                class FrameRing {
+                public:
+
+                    /**
+                     * Constructor
+                     */
+                    FrameRing() :
+                        _head(0),
+                        _tail(0),
+                        _dropped(0) {
+                        for (uint8_t i = 0; i < capacity; i++)
+                            _slots[i].store(nullptr, std::memory_order_relaxed);
+                    }
+
+                    /**
+                     * Publish a frame (producer side)
+                     */
+                    template<typename Recycle>
+                    void push(T *frame, Recycle recycle) {
+                        const uint32_t head = _head.load(std::memory_order_relaxed);
+                        uint32_t tail = _tail.load(std::memory_order_acquire);
+
+                        // ring is full: claim the oldest frame, unless the consumer takes it first
+                        while (head - tail >= capacity) {
+                            T *oldest = _slots[tail % capacity].load(std::memory_order_relaxed);
+
+                            if (_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                                _dropped.fetch_add(1, std::memory_order_relaxed);
+                                recycle(oldest);
+                                break;
+                            }
+                        }
+
+                        _slots[head % capacity].store(frame, std::memory_order_relaxed);
+                        _head.store(head + 1, std::memory_order_release);
+                    }
+
+                    /**
+                     * Take the newest frame (consumer side).
+                     * Returns nullptr if no new frame is available
+                     */
+                    template<typename Recycle>
+                    T* pop(Recycle recycle) {
+                        uint32_t tail = _tail.load(std::memory_order_acquire);
+
+                        while (true) {
+                            const uint32_t head = _head.load(std::memory_order_acquire);
+                            const uint32_t count = head - tail;
+                            T *frames[capacity];
+
+                            if (count == 0)
+                                return nullptr;
+
+                            // read before claiming: once tail moves, the producer may reuse the slots
+                            for (uint32_t i = 0; i < count; i++)
+                                frames[i] = _slots[(tail + i) % capacity].load(std::memory_order_relaxed);
+
+                            if (_tail.compare_exchange_weak(tail, head, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                                for (uint32_t i = 0; i + 1 < count; i++) {
+                                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                                    recycle(frames[i]);
+                                }
+
+                                return frames[count - 1];
+                            }
+                        }
+                    }
+
+                    /**
+                     * Recycle all pending frames
+                     */
+                    template<typename Recycle>
+                    void clear(Recycle recycle) {
+                        T *frame = pop(recycle);
+
+                        if (frame != nullptr)
+                            recycle(frame);
+                    }
+
+                    /**
+                     * Get number of frames that were never consumed
+                     */
+                    uint32_t dropped() const {
+                        return _dropped.load(std::memory_order_relaxed);
+                    }
+
+                protected:
+                    std::atomic<T*> _slots[capacity];
+                    std::atomic<uint32_t> _head;
+                    std::atomic<uint32_t> _tail;
+                    std::atomic<uint32_t> _dropped;
+                };
+            }
+        }
+    }
+}
+
+#endif
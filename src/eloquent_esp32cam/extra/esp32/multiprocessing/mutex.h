@@ -1,28 +1,43 @@
 #ifndef ELOQUENT_EXTRA_ESP32_MULTIPROCESSING_MUTEX
 #define ELOQUENT_EXTRA_ESP32_MULTIPROCESSING_MUTEX
 
+#include <stddef.h>
+#include "../../log.h"
+
+#if defined(ESP_PLATFORM)
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
-#include "esp_log.h"
+#else
+#include <chrono>
+#include <mutex>
+#include <thread>
+#endif
 
 namespace Eloquent {
     namespace Extra {
         namespace Esp32 {
             namespace Multiprocessing {
                 /**
-                 * Mutex for concurrent access to resource
+                 * Mutex for concurrent access to resource.
+                 * On the host, wraps a std::mutex
                  */
                 class Mutex {
                 public:
                     const char *name;
+#if defined(ESP_PLATFORM)
                     SemaphoreHandle_t mutex;
+#else
+                    std::mutex mutex;
+#endif
 
                     /**
                      * Constructor
                      */
                     Mutex(const char *name_) :
                         name(name_),
+#if defined(ESP_PLATFORM)
                         mutex(NULL),
+#endif
                         _ok(true) {
                     }
 
@@ -38,6 +53,7 @@ namespace Eloquent {
                      */
                     template<typename Callback>
                     bool threadsafe(Callback callback, size_t timeout = 0) {
+#if defined(ESP_PLATFORM)
                         TickType_t ticks = timeout / portTICK_PERIOD_MS;
 
                         if (timeout == 0) {
@@ -61,6 +77,27 @@ namespace Eloquent {
 
                         callback();
                         xSemaphoreGive(mutex);
+#else
+                        if (timeout == 0) {
+                            mutex.lock();
+                        }
+                        else {
+                            // poll instead of std::timed_mutex, whose clocklock sanitizers can't follow
+                            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+                            while (!mutex.try_lock()) {
+                                if (std::chrono::steady_clock::now() >= deadline) {
+                                    ESP_LOGW("Mutex", "Cannot acquire mutex %s within timeout", name);
+                                    return (_ok = false);
+                                }
+
+                                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                            }
+                        }
+
+                        callback();
+                        mutex.unlock();
+#endif
 
                         return (_ok = true);
                     }
@@ -0,0 +1,249 @@
+#ifndef ELOQUENT_EXTRA_ESP32_MULTIPROCESSING_PIPELINE
+#define ELOQUENT_EXTRA_ESP32_MULTIPROCESSING_PIPELINE
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include "./frame_ring.h"
+#include "./thread.h"
+
+namespace Eloquent {
+    namespace Extra {
+        namespace Esp32 {
+            namespace Multiprocessing {
+                /**
+                 * Two stage producer / consumer pipeline:
+                 * a capture task fills a frame ring on one core,
+                 * a processing task consumes the newest frame on the other core.
+                 * On the host, both stages run on pthreads
+                 */
+                template<typename Frame, uint8_t capacity = 1>
+                class Pipeline {
+                public:
+                    FrameRing<Frame, capacity> ring;
+
+                    /**
+                     * Constructor
+                     */
+                    Pipeline(const char *name) :
+                        _name(name),
+                        _captureThread("pipeline.capture"),
+                        _processThread("pipeline.process"),
+                        _running(false),
+                        _captureExited(true),
+                        _captured(0),
+                        _processed(0),
+                        _captureCore(0),
+                        _processCore(1),
+                        _captureStackSize(4096),
+                        _processStackSize(8192),
+                        _priority(5) {
+                    }
+
+                    /**
+                     * Set frame producer (return nullptr on failure)
+                     */
+                    Pipeline& onCapture(std::function<Frame*()> capture) {
+                        _capture = capture;
+
+                        return *this;
+                    }
+
+                    /**
+                     * Set frame consumer
+                     */
+                    Pipeline& onFrame(std::function<void(Frame*)> process) {
+                        _process = process;
+
+                        return *this;
+                    }
+
+                    /**
+                     * Set how frames are given back once processed or dropped
+                     */
+                    Pipeline& onRelease(std::function<void(Frame*)> release) {
+                        _release = release;
+
+                        return *this;
+                    }
+
+                    /**
+                     * Set cores for capture and processing tasks
+                     */
+                    Pipeline& onCores(uint8_t captureCore, uint8_t processCore) {
+                        _captureCore = captureCore;
+                        _processCore = processCore;
+
+                        return *this;
+                    }
+
+                    /**
+                     * Set stack size of capture and processing tasks
+                     */
+                    Pipeline& withStackSize(uint32_t captureStackSize, uint32_t processStackSize) {
+                        _captureStackSize = captureStackSize;
+                        _processStackSize = processStackSize;
+
+                        return *this;
+                    }
+
+                    /**
+                     * Set tasks priority
+                     */
+                    Pipeline& withPriority(uint8_t priority) {
+                        _priority = priority;
+
+                        return *this;
+                    }
+
+                    /**
+                     * Start both stages
+                     */
+                    bool start() {
+                        if (_running || !_capture || !_process || !_release)
+                            return false;
+
+                        _running = true;
+                        _captureExited = false;
+
+                        const bool processStarted = _processThread
+                            .withArgs(this)
+                            .withStackSize(_processStackSize)
+                            .withPriority(_priority)
+                            .onCore(_processCore)
+                            .run(processLoop);
+
+                        if (!processStarted) {
+                            _captureExited = true;
+                            return (_running = false);
+                        }
+
+                        const bool captureStarted = _captureThread
+                            .withArgs(this)
+                            .withStackSize(_captureStackSize)
+                            .withPriority(_priority)
+                            .onCore(_captureCore)
+                            .run(captureLoop);
+
+                        if (!captureStarted) {
+                            _captureExited = true;
+                            _running = false;
+                            _processThread.join();
+
+                            return false;
+                        }
+
+                        return true;
+                    }
+
+                    /**
+                     * Stop both stages and wait for them to exit
+                     */
+                    void stop() {
+                        _running = false;
+                        _captureThread.join();
+                        _processThread.notify();
+                        _processThread.join();
+                    }
+
+                    /**
+                     * Test if pipeline is running
+                     */
+                    bool isRunning() const {
+                        return _running;
+                    }
+
+                    /**
+                     * Get number of captured frames
+                     */
+                    uint32_t captured() const {
+                        return _captured;
+                    }
+
+                    /**
+                     * Get number of processed frames
+                     */
+                    uint32_t processed() const {
+                        return _processed;
+                    }
+
+                    /**
+                     * Get number of frames skipped in favour of newer ones
+                     */
+                    uint32_t dropped() const {
+                        return ring.dropped();
+                    }
+
+                protected:
+                    const char *_name;
+                    Thread _captureThread;
+                    Thread _processThread;
+                    std::atomic<bool> _running;
+                    std::atomic<bool> _captureExited;
+                    std::atomic<uint32_t> _captured;
+                    std::atomic<uint32_t> _processed;
+                    uint8_t _captureCore;
+                    uint8_t _processCore;
+                    uint32_t _captureStackSize;
+                    uint32_t _processStackSize;
+                    uint8_t _priority;
+                    std::function<Frame*()> _capture;
+                    std::function<void(Frame*)> _process;
+                    std::function<void(Frame*)> _release;
+
+                    /**
+                     * Capture stage
+                     */
+                    static void captureLoop(void *args) {
+                        Pipeline *self = (Pipeline*) args;
+                        auto release = [self](Frame *frame) { self->_release(frame); };
+
+                        while (self->_running) {
+                            Frame *frame = self->_capture();
+
+                            if (frame == nullptr) {
+                                Thread::sleep(1);
+                                continue;
+                            }
+
+                            self->_captured++;
+                            self->ring.push(frame, release);
+                            self->_processThread.notify();
+                        }
+
+                        self->_captureExited = true;
+                    }
+
+                    /**
+                     * Processing stage
+                     */
+                    static void processLoop(void *args) {
+                        Pipeline *self = (Pipeline*) args;
+                        auto release = [self](Frame *frame) { self->_release(frame); };
+
+                        while (self->_running) {
+                            Frame *frame = self->ring.pop(release);
+
+                            if (frame == nullptr) {
+                                self->_processThread.wait(100);
+                                continue;
+                            }
+
+                            self->_process(frame);
+                            self->_release(frame);
+                            self->_processed++;
+                        }
+
+                        // the capture task may still notify this one or push a last frame
+                        while (!self->_captureExited)
+                            Thread::sleep(1);
+
+                        self->ring.clear(release);
+                    }
+                };
+            }
+        }
+    }
+}
+
+#endif
@@ -1,15 +1,52 @@
 #ifndef ELOQUENT_EXTRA_ESP32_MULTIPROCESSING_THREAD
 #define ELOQUENT_EXTRA_ESP32_MULTIPROCESSING_THREAD
 
+#include <stdint.h>
+#include <atomic>
+
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#else
+#include <pthread.h>
+#include <limits.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
 namespace Eloquent {
     namespace Extra {
         namespace Esp32 {
             namespace Multiprocessing {
                 /**
-                 * Run task on given core
+                 * Preallocated stack and control block for a thread
+                 * (no heap allocation when the thread starts)
+                 */
+                template<uint32_t stackSize>
+                struct ThreadMemory {
+                    alignas(16) uint8_t stack[stackSize];
+#if defined(ESP_PLATFORM)
+                    StaticTask_t tcb;
+#endif
+                };
+
+                /**
+                 * Run task on given core.
+                 * On the host, runs on a pthread (pinned on Linux)
                  */
                 class Thread {
                 public:
+                    typedef void (*TaskFunction)(void*);
+
+#if defined(ESP_PLATFORM)
+                    TaskHandle_t handle;
+#else
+                    pthread_t handle;
+#endif
 
                     /**
                      *
@@ -19,11 +56,24 @@ namespace Eloquent {
                         name(threadName),
                         args(NULL), // Initialize args to NULL
                         priority(0),
-                        stackSize(1000)
-                        
+                        stackSize(1000),
+                        staticStack(NULL),
+                        staticTCB(NULL),
+                        task(NULL),
+                        running(false),
+                        started(false)
                     {
+#if defined(ESP_PLATFORM)
+                        handle = NULL;
                         core = xPortGetCoreID();
+                        done = xSemaphoreCreateBinaryStatic(&doneBuffer);
+                        lifecycle = xSemaphoreCreateMutexStatic(&lifecycleBuffer);
+#else
+                        core = 0;
+                        notifications = 0;
+#endif
                     }
+
                     /**
                      * Set task args
                      * @return
@@ -56,15 +106,31 @@ namespace Eloquent {
                     }
 
                     /**
-                     * Set stack size
+                     * Set stack size (in bytes)
                      * @return
                      */
-                    Thread& withStackSize(uint16_t stackSize) {
+                    Thread& withStackSize(uint32_t stackSize) {
                         this->stackSize = stackSize;
 
                         return *this;
                     }
 
+                    /**
+                     * Use preallocated stack and control block.
+                     * Memory must outlive the thread
+                     * @return
+                     */
+                    template<uint32_t size>
+                    Thread& withStaticMemory(ThreadMemory<size>& memory) {
+                        stackSize = size;
+                        staticStack = memory.stack;
+#if defined(ESP_PLATFORM)
+                        staticTCB = &memory.tcb;
+#endif
+
+                        return *this;
+                    }
+
                     /**
                      * Set pinned core
                      * @return
@@ -76,24 +142,214 @@ namespace Eloquent {
                     }
 
                     /**
-                     * Create task
+                     * Let the scheduler pick the core
+                     * @return
+                     */
+                    Thread& onAnyCore() {
+#if defined(ESP_PLATFORM)
+                        core = tskNO_AFFINITY;
+#else
+                        core = 0xFF;
+#endif
+
+                        return *this;
+                    }
+
+                    /**
+                     * Create task.
+                     * Return from the task instead of deleting it, so join() can tell it finished
                      * @tparam Task
-                     * @param name
                      * @param task
                      */
                     template<typename Task>
-                    void run(Task task) {
+                    bool run(Task task) {
+                        if (running)
+                            return false;
+
+#if !defined(ESP_PLATFORM)
+                        // reap the previous run
+                        if (started.exchange(false))
+                            pthread_join(handle, NULL);
+#endif
+
+                        this->task = task;
+                        running = true;
+                        started = true;
+
+#if defined(ESP_PLATFORM)
                         ESP_LOGI(name, "Starting thread with stack size %d bytes on core %d", (int) stackSize, (int) core);
 
-                        xTaskCreatePinnedToCore(
-                            task,      // Function to implement the task
-                            name,      // Name of the task
-                            stackSize, // Stack size in bytes
-                            args,      // Task input parameter
-                            priority,  // Priority of the task
-                            NULL,       // Task handle.
-                            0
-                        );
+                        xSemaphoreTake(done, 0);
+                        // notify() must not see the previous (deleted) handle
+                        xSemaphoreTake(lifecycle, portMAX_DELAY);
+
+                        if (staticStack != NULL && staticTCB != NULL) {
+                            handle = xTaskCreateStaticPinnedToCore(
+                                entry,                      // Function to implement the task
+                                name,                       // Name of the task
+                                stackSize,                  // Stack size in bytes
+                                this,                       // Task input parameter
+                                priority,                   // Priority of the task
+                                (StackType_t*) staticStack, // Preallocated stack
+                                (StaticTask_t*) staticTCB,  // Preallocated control block
+                                core
+                            );
+                        }
+                        else if (xTaskCreatePinnedToCore(entry, name, stackSize, this, priority, &handle, core) != pdPASS) {
+                            handle = NULL;
+                        }
+
+                        if (handle == NULL) {
+                            running = false;
+                            started = false;
+                        }
+
+                        xSemaphoreGive(lifecycle);
+
+                        if (handle == NULL) {
+                            ESP_LOGE(name, "Cannot start thread");
+                            return false;
+                        }
+#else
+                        pthread_attr_t attr;
+                        pthread_attr_init(&attr);
+
+                        // host stacks need more room than FreeRTOS ones
+                        size_t hostStackSize = stackSize < PTHREAD_STACK_MIN ? PTHREAD_STACK_MIN : stackSize;
+
+                        if (staticStack != NULL && stackSize >= PTHREAD_STACK_MIN)
+                            pthread_attr_setstack(&attr, staticStack, stackSize);
+                        else
+                            pthread_attr_setstacksize(&attr, hostStackSize);
+
+                        const int err = pthread_create(&handle, &attr, hostEntry, this);
+                        pthread_attr_destroy(&attr);
+
+                        if (err != 0) {
+                            started = false;
+                            return (running = false);
+                        }
+
+#if defined(__linux__)
+                        if (core != 0xFF && core < std::thread::hardware_concurrency()) {
+                            cpu_set_t cpus;
+                            CPU_ZERO(&cpus);
+                            CPU_SET(core, &cpus);
+                            pthread_setaffinity_np(handle, sizeof(cpus), &cpus);
+                        }
+#endif
+#endif
+
+                        return true;
+                    }
+
+                    /**
+                     * Test if task is running
+                     */
+                    bool isRunning() const {
+                        return running;
+                    }
+
+                    /**
+                     * Wait for the task to return.
+                     * @param timeout in millis (0 = forever)
+                     * @return false on timeout
+                     */
+                    bool join(uint32_t timeout = 0) {
+                        if (!started)
+                            return true;
+
+#if defined(ESP_PLATFORM)
+                        TickType_t ticks = timeout == 0 ? portMAX_DELAY : timeout / portTICK_PERIOD_MS;
+
+                        if (ticks == 0)
+                            ticks = 1;
+
+                        if (xSemaphoreTake(done, ticks) != pdTRUE)
+                            return false;
+
+                        // leave it given for other joiners
+                        xSemaphoreGive(done);
+#else
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            auto isDone = [this]() { return !running; };
+
+                            if (timeout == 0)
+                                cond.wait(lock, isDone);
+                            else if (!cond.wait_for(lock, std::chrono::milliseconds(timeout), isDone))
+                                return false;
+                        }
+
+                        if (started.exchange(false))
+                            pthread_join(handle, NULL);
+#endif
+
+                        return true;
+                    }
+
+                    /**
+                     * Wake up the task (see wait()).
+                     * No-op once the task has exited
+                     */
+                    void notify() {
+#if defined(ESP_PLATFORM)
+                        // the task cannot delete itself between the check and the give
+                        xSemaphoreTake(lifecycle, portMAX_DELAY);
+
+                        if (running && handle != NULL)
+                            xTaskNotifyGive(handle);
+
+                        xSemaphoreGive(lifecycle);
+#else
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            notifications++;
+                        }
+                        cond.notify_all();
+#endif
+                    }
+
+                    /**
+                     * Wait for a notification.
+                     * Must be called from the task itself
+                     * @param timeout in millis (0 = forever)
+                     * @return false on timeout
+                     */
+                    bool wait(uint32_t timeout = 0) {
+#if defined(ESP_PLATFORM)
+                        TickType_t ticks = timeout == 0 ? portMAX_DELAY : timeout / portTICK_PERIOD_MS;
+
+                        if (ticks == 0)
+                            ticks = 1;
+
+                        return ulTaskNotifyTake(pdTRUE, ticks) > 0;
+#else
+                        std::unique_lock<std::mutex> lock(mutex);
+                        auto isNotified = [this]() { return notifications > 0; };
+
+                        if (timeout == 0)
+                            cond.wait(lock, isNotified);
+                        else if (!cond.wait_for(lock, std::chrono::milliseconds(timeout), isNotified))
+                            return false;
+
+                        notifications = 0;
+
+                        return true;
+#endif
+                    }
+
+                    /**
+                     * Sleep the current task
+                     */
+                    static void sleep(uint32_t millis) {
+#if defined(ESP_PLATFORM)
+                        const TickType_t ticks = millis / portTICK_PERIOD_MS;
+
+                        vTaskDelay(ticks > 0 ? ticks : 1);
+#else
+                        std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+#endif
                     }
 
                 private:
@@ -101,7 +357,60 @@ namespace Eloquent {
                     uint8_t core;
                     void *args;
                     uint8_t priority;
-                    uint16_t stackSize;
+                    uint32_t stackSize;
+                    uint8_t *staticStack;
+                    void *staticTCB;
+                    TaskFunction task;
+                    std::atomic<bool> running;
+                    std::atomic<bool> started;
+#if defined(ESP_PLATFORM)
+                    SemaphoreHandle_t done;
+                    StaticSemaphore_t doneBuffer;
+                    SemaphoreHandle_t lifecycle;
+                    StaticSemaphore_t lifecycleBuffer;
+#else
+                    std::mutex mutex;
+                    std::condition_variable cond;
+                    uint32_t notifications;
+#endif
+
+#if defined(ESP_PLATFORM)
+                    /**
+                     * Run the task, then flag it as done.
+                     * The handle is cleared under the lifecycle mutex, so notify()
+                     * never gives to a deleted task
+                     */
+                    static void entry(void *self) {
+                        Thread *thread = (Thread*) self;
+
+                        thread->task(thread->args);
+
+                        xSemaphoreTake(thread->lifecycle, portMAX_DELAY);
+                        thread->running = false;
+                        thread->handle = NULL;
+                        xSemaphoreGive(thread->lifecycle);
+
+                        xSemaphoreGive(thread->done);
+                        vTaskDelete(NULL);
+                    }
+#else
+                    /**
+                     * Run the task, then flag it as done
+                     */
+                    static void* hostEntry(void *self) {
+                        Thread *thread = (Thread*) self;
+
+                        thread->task(thread->args);
+
+                        {
+                            std::lock_guard<std::mutex> lock(thread->mutex);
+                            thread->running = false;
+                        }
+                        thread->cond.notify_all();
+
+                        return NULL;
+                    }
+#endif
                 };
             }
         }
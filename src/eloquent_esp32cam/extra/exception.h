@@ -2,7 +2,7 @@
 #define ELOQUENT_EXCEPTION_H
 
 #include <string>
-#include <esp_log.h>
+#include "./log.h"
 
 namespace Eloquent {
     namespace Error {
@@ -0,0 +1,564 @@
+#ifndef ELOQUENT_EXTRA_HOST_ESP_CAMERA
+#define ELOQUENT_EXTRA_HOST_ESP_CAMERA
+
+/**
+ * Host stand-in for the esp32-camera driver: same types and the same
+ * esp_camera_fb_get() / esp_camera_fb_return() contract (at most fb_count
+ * frames out at once, fb_get() waits for one to be returned), with frames
+ * rendered by a FrameSource instead of a sensor.
+ *
+ * The source is picked with Eloquent::Extra::Host::cameraDriver().source(),
+ * or with environment variables so unchanged application code can run:
+ *   ELOQUENT_CAMERA_FRAMES  folder of .ppm frames (synthetic frames otherwise)
+ *   ELOQUENT_CAMERA_FPS     sensor frame rate (as fast as possible otherwise)
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "./esp_log.h"
+#include "./frame_source.h"
+#include "../time/clock.h"
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_NOT_SUPPORTED   0x106
+
+typedef enum {
+    PIXFORMAT_RGB565,
+    PIXFORMAT_YUV422,
+    PIXFORMAT_YUV420,
+    PIXFORMAT_GRAYSCALE,
+    PIXFORMAT_JPEG,
+    PIXFORMAT_RGB888,
+    PIXFORMAT_RAW,
+    PIXFORMAT_RGB444,
+    PIXFORMAT_RGB555,
+} pixformat_t;
+
+typedef enum {
+    FRAMESIZE_96X96,
+    FRAMESIZE_QQVGA,
+    FRAMESIZE_QCIF,
+    FRAMESIZE_HQVGA,
+    FRAMESIZE_240X240,
+    FRAMESIZE_QVGA,
+    FRAMESIZE_CIF,
+    FRAMESIZE_HVGA,
+    FRAMESIZE_VGA,
+    FRAMESIZE_SVGA,
+    FRAMESIZE_XGA,
+    FRAMESIZE_HD,
+    FRAMESIZE_SXGA,
+    FRAMESIZE_UXGA,
+    FRAMESIZE_FHD,
+    FRAMESIZE_P_HD,
+    FRAMESIZE_P_3MP,
+    FRAMESIZE_QXGA,
+    FRAMESIZE_QHD,
+    FRAMESIZE_WQXGA,
+    FRAMESIZE_P_FHD,
+    FRAMESIZE_QSXGA,
+    FRAMESIZE_INVALID
+} framesize_t;
+
+typedef enum {
+    GAINCEILING_2X,
+    GAINCEILING_4X,
+    GAINCEILING_8X,
+    GAINCEILING_16X,
+    GAINCEILING_32X,
+    GAINCEILING_64X,
+    GAINCEILING_128X,
+} gainceiling_t;
+
+typedef enum {
+    CAMERA_GRAB_WHEN_EMPTY,
+    CAMERA_GRAB_LATEST
+} camera_grab_mode_t;
+
+typedef enum {
+    CAMERA_FB_IN_PSRAM,
+    CAMERA_FB_IN_DRAM
+} camera_fb_location_t;
+
+typedef enum { LEDC_TIMER_0, LEDC_TIMER_1, LEDC_TIMER_2, LEDC_TIMER_3 } ledc_timer_t;
+typedef enum { LEDC_CHANNEL_0, LEDC_CHANNEL_1, LEDC_CHANNEL_2, LEDC_CHANNEL_3, LEDC_CHANNEL_4, LEDC_CHANNEL_5, LEDC_CHANNEL_6, LEDC_CHANNEL_7 } ledc_channel_t;
+
+typedef struct {
+    int pin_pwdn;
+    int pin_reset;
+    int pin_xclk;
+    int pin_sccb_sda;
+    int pin_sccb_scl;
+    int pin_d7;
+    int pin_d6;
+    int pin_d5;
+    int pin_d4;
+    int pin_d3;
+    int pin_d2;
+    int pin_d1;
+    int pin_d0;
+    int pin_vsync;
+    int pin_href;
+    int pin_pclk;
+    int xclk_freq_hz;
+    ledc_timer_t ledc_timer;
+    ledc_channel_t ledc_channel;
+    pixformat_t pixel_format;
+    framesize_t frame_size;
+    int jpeg_quality;
+    size_t fb_count;
+    camera_fb_location_t fb_location;
+    camera_grab_mode_t grab_mode;
+    int sccb_i2c_port;
+} camera_config_t;
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t width;
+    size_t height;
+    pixformat_t format;
+    struct timeval timestamp;
+} camera_fb_t;
+
+typedef enum {
+    JPG_SCALE_NONE,
+    JPG_SCALE_2X,
+    JPG_SCALE_4X,
+    JPG_SCALE_8X,
+    JPG_SCALE_MAX = JPG_SCALE_8X
+} jpg_scale_t;
+
+typedef struct {
+    framesize_t framesize;
+    int vflip;
+    int hmirror;
+} camera_status_t;
+
+typedef struct _sensor sensor_t;
+
+typedef struct _sensor {
+    pixformat_t pixformat;
+    camera_status_t status;
+    int (*set_pixformat)(sensor_t *sensor, pixformat_t pixformat);
+    int (*set_framesize)(sensor_t *sensor, framesize_t framesize);
+    int (*set_contrast)(sensor_t *sensor, int level);
+    int (*set_brightness)(sensor_t *sensor, int level);
+    int (*set_saturation)(sensor_t *sensor, int level);
+    int (*set_sharpness)(sensor_t *sensor, int level);
+    int (*set_denoise)(sensor_t *sensor, int level);
+    int (*set_gainceiling)(sensor_t *sensor, gainceiling_t gainceiling);
+    int (*set_quality)(sensor_t *sensor, int quality);
+    int (*set_colorbar)(sensor_t *sensor, int enable);
+    int (*set_whitebal)(sensor_t *sensor, int enable);
+    int (*set_gain_ctrl)(sensor_t *sensor, int enable);
+    int (*set_exposure_ctrl)(sensor_t *sensor, int enable);
+    int (*set_hmirror)(sensor_t *sensor, int enable);
+    int (*set_vflip)(sensor_t *sensor, int enable);
+    int (*set_aec2)(sensor_t *sensor, int enable);
+    int (*set_awb_gain)(sensor_t *sensor, int enable);
+    int (*set_agc_gain)(sensor_t *sensor, int gain);
+    int (*set_aec_value)(sensor_t *sensor, int gain);
+    int (*set_special_effect)(sensor_t *sensor, int effect);
+    int (*set_wb_mode)(sensor_t *sensor, int mode);
+    int (*set_ae_level)(sensor_t *sensor, int level);
+    int (*set_dcw)(sensor_t *sensor, int enable);
+    int (*set_bpc)(sensor_t *sensor, int enable);
+    int (*set_wpc)(sensor_t *sensor, int enable);
+    int (*set_raw_gma)(sensor_t *sensor, int enable);
+    int (*set_lenc)(sensor_t *sensor, int enable);
+} sensor_t;
+
+namespace Eloquent {
+    namespace Extra {
+        namespace Host {
+            /**
+             * Simulated camera behind the esp_camera_* functions
+             */
+            class CameraDriver {
+            public:
+                /**
+                 * Constructor
+                 */
+                CameraDriver() :
+                    _source(NULL),
+                    _periodUs(0),
+                    _nextFrameUs(0),
+                    _index(0),
+                    _initialized(false) {
+                    memset(&_sensor, 0, sizeof(_sensor));
+                    memset(&_config, 0, sizeof(_config));
+                    initSensor();
+
+                    const char *folder = getenv("ELOQUENT_CAMERA_FRAMES");
+                    const char *fps = getenv("ELOQUENT_CAMERA_FPS");
+
+                    if (folder != NULL)
+                        _defaultSource.reset(new FileFrames(folder));
+                    else
+                        _defaultSource.reset(new SyntheticFrames());
+
+                    if (fps != NULL)
+                        this->fps(atof(fps));
+                }
+
+                /**
+                 * Set frame source (must outlive the driver, NULL = default source)
+                 */
+                CameraDriver& source(FrameSource *source) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _source = source;
+
+                    return *this;
+                }
+
+                /**
+                 * Limit the frame rate like a sensor would (0 = as fast as possible)
+                 */
+                CameraDriver& fps(float fps) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _periodUs = fps > 0 ? (int64_t) (1000000 / fps) : 0;
+
+                    return *this;
+                }
+
+                /**
+                 * Get number of frames captured so far
+                 */
+                uint32_t captured() {
+                    std::lock_guard<std::mutex> lock(_mutex);
+
+                    return _index;
+                }
+
+                /**
+                 * esp_camera_init()
+                 */
+                esp_err_t init(const camera_config_t *config) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+
+                    if (_initialized)
+                        return ESP_ERR_INVALID_STATE;
+
+                    if (bytesPerPixel(config->pixel_format) == 0) {
+                        ESP_LOGE("Camera", "Pixel format %d is not simulated on the host", (int) config->pixel_format);
+                        return ESP_ERR_NOT_SUPPORTED;
+                    }
+
+                    _config = *config;
+                    _sensor.pixformat = config->pixel_format;
+                    _sensor.status.framesize = config->frame_size;
+                    _slots.clear();
+
+                    for (size_t i = 0; i < (config->fb_count > 0 ? config->fb_count : 1); i++)
+                        _slots.emplace_back(new Slot());
+
+                    _initialized = true;
+
+                    return ESP_OK;
+                }
+
+                /**
+                 * esp_camera_deinit()
+                 */
+                esp_err_t deinit() {
+                    std::lock_guard<std::mutex> lock(_mutex);
+
+                    for (auto &slot : _slots)
+                        if (slot->taken)
+                            ESP_LOGW("Camera", "Frame buffer still in use on deinit");
+
+                    _slots.clear();
+                    _initialized = false;
+
+                    return ESP_OK;
+                }
+
+                /**
+                 * esp_camera_fb_get().
+                 * Waits up to 4 seconds for a frame buffer to be returned, like the driver
+                 */
+                camera_fb_t* get() {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    Slot *slot = NULL;
+
+                    if (!_initialized)
+                        return NULL;
+
+                    const bool available = _returned.wait_for(lock, std::chrono::seconds(4), [this, &slot]() {
+                        for (auto &candidate : _slots) {
+                            if (!candidate->taken) {
+                                slot = candidate.get();
+                                return true;
+                            }
+                        }
+
+                        return !_initialized;
+                    });
+
+                    if (!available || slot == NULL) {
+                        ESP_LOGW("Camera", "Failed to get the frame on time!");
+                        return NULL;
+                    }
+
+                    slot->taken = true;
+
+                    FrameSource *source = _source != NULL ? _source : _defaultSource.get();
+                    const pixformat_t format = _sensor.pixformat;
+                    const bool vflip = _sensor.status.vflip;
+                    const bool hmirror = _sensor.status.hmirror;
+                    const uint32_t index = _index++;
+                    uint16_t width, height;
+
+                    frameSize(_sensor.status.framesize, &width, &height);
+
+                    // sensor frame rate
+                    int64_t now = Time::Clock::micros();
+
+                    if (_periodUs > 0) {
+                        const int64_t at = _nextFrameUs > now ? _nextFrameUs : now;
+
+                        _nextFrameUs = at + _periodUs;
+                        lock.unlock();
+                        std::this_thread::sleep_for(std::chrono::microseconds(at - now));
+                    }
+                    else {
+                        lock.unlock();
+                    }
+
+                    // the slot is ours until it's returned, render it unlocked
+                    slot->rgb.resize((size_t) width * height * 3);
+
+                    if (!source->read(index, width, height, slot->rgb.data())) {
+                        release(&slot->fb);
+                        return NULL;
+                    }
+
+                    encode(slot, width, height, format, vflip, hmirror);
+                    now = Time::Clock::micros();
+                    slot->fb.timestamp.tv_sec = now / 1000000;
+                    slot->fb.timestamp.tv_usec = now % 1000000;
+
+                    return &slot->fb;
+                }
+
+                /**
+                 * esp_camera_fb_return()
+                 */
+                void release(camera_fb_t *fb) {
+                    {
+                        std::lock_guard<std::mutex> lock(_mutex);
+
+                        for (auto &slot : _slots)
+                            if (&slot->fb == fb)
+                                slot->taken = false;
+                    }
+
+                    _returned.notify_all();
+                }
+
+                /**
+                 * esp_camera_sensor_get()
+                 */
+                sensor_t* sensor() {
+                    return &_sensor;
+                }
+
+                /**
+                 * Get size of frame size
+                 */
+                static bool frameSize(framesize_t framesize, uint16_t *width, uint16_t *height) {
+                    static const uint16_t sizes[FRAMESIZE_INVALID][2] = {
+                        {96, 96}, {160, 120}, {176, 144}, {240, 176}, {240, 240}, {320, 240},
+                        {400, 296}, {480, 320}, {640, 480}, {800, 600}, {1024, 768}, {1280, 720},
+                        {1280, 1024}, {1600, 1200}, {1920, 1080}, {720, 1280}, {864, 1536},
+                        {2048, 1536}, {2560, 1440}, {2560, 1600}, {1080, 1920}, {2560, 1920}
+                    };
+                    const bool valid = framesize >= 0 && framesize < FRAMESIZE_INVALID;
+
+                    *width = valid ? sizes[framesize][0] : 96;
+                    *height = valid ? sizes[framesize][1] : 96;
+
+                    return valid;
+                }
+
+            protected:
+                struct Slot {
+                    Slot() : taken(false) {
+                        memset(&fb, 0, sizeof(fb));
+                    }
+
+                    camera_fb_t fb;
+                    bool taken;
+                    std::vector<uint8_t> data;
+                    std::vector<uint8_t> rgb;
+                };
+
+                std::mutex _mutex;
+                std::condition_variable _returned;
+                std::vector<std::unique_ptr<Slot>> _slots;
+                std::unique_ptr<FrameSource> _defaultSource;
+                FrameSource *_source;
+                camera_config_t _config;
+                sensor_t _sensor;
+                int64_t _periodUs;
+                int64_t _nextFrameUs;
+                uint32_t _index;
+                bool _initialized;
+
+                /**
+                 * Bytes per pixel of simulated formats (0 if not simulated)
+                 */
+                static size_t bytesPerPixel(pixformat_t format) {
+                    switch (format) {
+                        case PIXFORMAT_RGB565: return 2;
+                        case PIXFORMAT_GRAYSCALE: return 1;
+                        case PIXFORMAT_RGB888: return 3;
+                        default: return 0;
+                    }
+                }
+
+                /**
+                 * Convert the rendered RGB888 frame to the sensor format
+                 * (RGB565 is big endian, like the driver returns it)
+                 */
+                static void encode(Slot *slot, uint16_t width, uint16_t height, pixformat_t format, bool vflip, bool hmirror) {
+                    const size_t bpp = bytesPerPixel(format);
+
+                    slot->data.resize((size_t) width * height * bpp);
+
+                    for (uint16_t y = 0; y < height; y++) {
+                        for (uint16_t x = 0; x < width; x++) {
+                            const size_t sy = vflip ? height - 1 - y : y;
+                            const size_t sx = hmirror ? width - 1 - x : x;
+                            const uint8_t *rgb = slot->rgb.data() + (sy * width + sx) * 3;
+                            uint8_t *out = slot->data.data() + ((size_t) y * width + x) * bpp;
+
+                            if (format == PIXFORMAT_RGB565) {
+                                const uint16_t pixel = ((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) | (rgb[2] >> 3);
+
+                                out[0] = pixel >> 8;
+                                out[1] = pixel & 0xFF;
+                            }
+                            else if (format == PIXFORMAT_GRAYSCALE) {
+                                out[0] = (rgb[0] * 77 + rgb[1] * 150 + rgb[2] * 29) >> 8;
+                            }
+                            else {
+                                memcpy(out, rgb, 3);
+                            }
+                        }
+                    }
+
+                    slot->fb.buf = slot->data.data();
+                    slot->fb.len = slot->data.size();
+                    slot->fb.width = width;
+                    slot->fb.height = height;
+                    slot->fb.format = format;
+                }
+
+                /**
+                 * Hook the sensor setters: frame size, pixel format, flip and
+                 * mirror change the frames, image tuning is accepted and ignored
+                 */
+                void initSensor();
+            };
+
+            /**
+             * Get the simulated camera
+             */
+            inline CameraDriver& cameraDriver() {
+                static CameraDriver driver;
+
+                return driver;
+            }
+
+            inline void CameraDriver::initSensor() {
+                auto ignore = [](sensor_t *sensor, int value) { return 0; };
+
+                _sensor.set_pixformat = [](sensor_t *sensor, pixformat_t pixformat) {
+                    if (pixformat != PIXFORMAT_RGB565 && pixformat != PIXFORMAT_GRAYSCALE && pixformat != PIXFORMAT_RGB888)
+                        return -1;
+
+                    sensor->pixformat = pixformat;
+                    return 0;
+                };
+                _sensor.set_framesize = [](sensor_t *sensor, framesize_t framesize) {
+                    uint16_t width, height;
+
+                    if (!CameraDriver::frameSize(framesize, &width, &height))
+                        return -1;
+
+                    sensor->status.framesize = framesize;
+                    return 0;
+                };
+                _sensor.set_vflip = [](sensor_t *sensor, int enable) { sensor->status.vflip = enable; return 0; };
+                _sensor.set_hmirror = [](sensor_t *sensor, int enable) { sensor->status.hmirror = enable; return 0; };
+                _sensor.set_gainceiling = [](sensor_t *sensor, gainceiling_t gainceiling) { return 0; };
+                _sensor.set_contrast = ignore;
+                _sensor.set_brightness = ignore;
+                _sensor.set_saturation = ignore;
+                _sensor.set_sharpness = ignore;
+                _sensor.set_denoise = ignore;
+                _sensor.set_quality = ignore;
+                _sensor.set_colorbar = ignore;
+                _sensor.set_whitebal = ignore;
+                _sensor.set_gain_ctrl = ignore;
+                _sensor.set_exposure_ctrl = ignore;
+                _sensor.set_aec2 = ignore;
+                _sensor.set_awb_gain = ignore;
+                _sensor.set_agc_gain = ignore;
+                _sensor.set_aec_value = ignore;
+                _sensor.set_special_effect = ignore;
+                _sensor.set_wb_mode = ignore;
+                _sensor.set_ae_level = ignore;
+                _sensor.set_dcw = ignore;
+                _sensor.set_bpc = ignore;
+                _sensor.set_wpc = ignore;
+                _sensor.set_raw_gma = ignore;
+                _sensor.set_lenc = ignore;
+            }
+        }
+    }
+}
+
+inline esp_err_t esp_camera_init(const camera_config_t *config) {
+    return Eloquent::Extra::Host::cameraDriver().init(config);
+}
+
+inline esp_err_t esp_camera_deinit() {
+    return Eloquent::Extra::Host::cameraDriver().deinit();
+}
+
+inline camera_fb_t* esp_camera_fb_get() {
+    return Eloquent::Extra::Host::cameraDriver().get();
+}
+
+inline void esp_camera_fb_return(camera_fb_t *fb) {
+    Eloquent::Extra::Host::cameraDriver().release(fb);
+}
+
+inline sensor_t* esp_camera_sensor_get() {
+    return Eloquent::Extra::Host::cameraDriver().sensor();
+}
+
+/**
+ * The simulated camera never returns JPEG frames
+ */
+inline bool jpg2rgb565(const uint8_t *src, size_t src_len, uint8_t *out, jpg_scale_t scale) {
+    return false;
+}
+
+#endif
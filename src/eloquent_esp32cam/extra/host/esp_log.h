@@ -0,0 +1,16 @@
+#ifndef ELOQUENT_EXTRA_HOST_ESP_LOG
+#define ELOQUENT_EXTRA_HOST_ESP_LOG
+
+#include <stdio.h>
+
+/**
+ * Host stand-in for the ESP-IDF logging macros.
+ * Errors, warnings and info go to stderr, debug and verbose are dropped
+ */
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) fprintf(stderr, "I %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do { } while (0)
+#define ESP_LOGV(tag, format, ...) do { } while (0)
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef ELOQUENT_EXTRA_HOST_FRAME_SOURCE
+#define ELOQUENT_EXTRA_HOST_FRAME_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace Eloquent {
+    namespace Extra {
+        namespace Host {
+            /**
+             * Where the simulated camera gets its frames from
+             */
+            class FrameSource {
+            public:
+                virtual ~FrameSource() {}
+
+                /**
+                 * Render frame number `index` as RGB888
+                 * @param rgb width * height * 3 bytes
+                 * @return false if there is no frame
+                 */
+                virtual bool read(uint32_t index, uint16_t width, uint16_t height, uint8_t *rgb) = 0;
+            };
+
+            /**
+             * Gradient background with a square that moves for
+             * `moving` frames, then holds still for `still` frames
+             * (so motion gating has both cases to deal with)
+             */
+            class SyntheticFrames : public FrameSource {
+            public:
+                /**
+                 * Constructor
+                 */
+                SyntheticFrames(uint16_t moving = 30, uint16_t still = 30) :
+                    _moving(moving),
+                    _still(still) {
+                }
+
+                /**
+                 * Render frame
+                 */
+                bool read(uint32_t index, uint16_t width, uint16_t height, uint8_t *rgb) override {
+                    const uint32_t period = (uint32_t) _moving + _still;
+                    const uint32_t cycle = period > 0 ? index / period : 0;
+                    const uint32_t phase = period > 0 ? index % period : 0;
+                    const uint32_t step = cycle * _moving + (phase < _moving ? phase : _moving);
+                    const uint16_t side = std::max(1, std::min(width, height) / 4);
+                    const uint16_t x0 = (step * 3) % std::max(1, width - side);
+                    const uint16_t y0 = (step * 2) % std::max(1, height - side);
+
+                    for (uint16_t y = 0; y < height; y++) {
+                        for (uint16_t x = 0; x < width; x++) {
+                            uint8_t *pixel = rgb + ((size_t) y * width + x) * 3;
+                            const bool inside = x >= x0 && x < x0 + side && y >= y0 && y < y0 + side;
+
+                            pixel[0] = inside ? 240 : (x * 128) / width;
+                            pixel[1] = inside ? 200 : (y * 128) / height;
+                            pixel[2] = inside ? 40 : 64;
+                        }
+                    }
+
+                    return true;
+                }
+
+            protected:
+                uint16_t _moving;
+                uint16_t _still;
+            };
+
+            /**
+             * Binary PPM (P6) files of a folder, in name order, looped.
+             * Frames are scaled (nearest neighbor) to the configured frame size
+             */
+            class FileFrames : public FrameSource {
+            public:
+                /**
+                 * Load all .ppm files of folder
+                 */
+                FileFrames(const char *folder) {
+                    DIR *dir = opendir(folder);
+                    std::vector<std::string> names;
+
+                    if (dir == NULL) {
+                        fprintf(stderr, "E FileFrames: Cannot open %s\n", folder);
+                        return;
+                    }
+
+                    while (struct dirent *entry = readdir(dir)) {
+                        const std::string name = entry->d_name;
+
+                        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".ppm") == 0)
+                            names.push_back(name);
+                    }
+
+                    closedir(dir);
+                    std::sort(names.begin(), names.end());
+
+                    for (const std::string &name : names) {
+                        Image image;
+
+                        if (load(std::string(folder) + "/" + name, image))
+                            _images.push_back(image);
+                        else
+                            fprintf(stderr, "E FileFrames: %s is not a 8 bit binary PPM\n", name.c_str());
+                    }
+                }
+
+                /**
+                 * Get number of frames
+                 */
+                size_t count() const {
+                    return _images.size();
+                }
+
+                /**
+                 * Render frame
+                 */
+                bool read(uint32_t index, uint16_t width, uint16_t height, uint8_t *rgb) override {
+                    if (_images.empty())
+                        return false;
+
+                    const Image &image = _images[index % _images.size()];
+
+                    for (uint16_t y = 0; y < height; y++) {
+                        const uint8_t *row = image.rgb.data() + ((size_t) y * image.height / height) * image.width * 3;
+
+                        for (uint16_t x = 0; x < width; x++)
+                            memcpy(rgb + ((size_t) y * width + x) * 3, row + ((size_t) x * image.width / width) * 3, 3);
+                    }
+
+                    return true;
+                }
+
+            protected:
+                struct Image {
+                    uint32_t width;
+                    uint32_t height;
+                    std::vector<uint8_t> rgb;
+                };
+
+                std::vector<Image> _images;
+
+                /**
+                 * Read next number of PPM header, skipping whitespace and comments
+                 */
+                static bool readNumber(FILE *f, uint32_t &value) {
+                    int c = fgetc(f);
+
+                    while (c == '#' || isspace(c)) {
+                        if (c == '#')
+                            while (c != '\n' && c != EOF)
+                                c = fgetc(f);
+
+                        c = fgetc(f);
+                    }
+
+                    if (!isdigit(c))
+                        return false;
+
+                    for (value = 0; isdigit(c); c = fgetc(f))
+                        value = value * 10 + (c - '0');
+
+                    // c is the single whitespace before the next field (or the pixels)
+                    return isspace(c);
+                }
+
+                /**
+                 * Load PPM file
+                 */
+                static bool load(const std::string &path, Image &image) {
+                    FILE *f = fopen(path.c_str(), "rb");
+                    uint32_t maxval;
+
+                    if (f == NULL)
+                        return false;
+
+                    const bool ok = fgetc(f) == 'P' && fgetc(f) == '6'
+                        && readNumber(f, image.width) && readNumber(f, image.height) && readNumber(f, maxval)
+                        && maxval == 255 && image.width > 0 && image.height > 0;
+
+                    if (ok) {
+                        image.rgb.resize((size_t) image.width * image.height * 3);
+                        image.rgb.resize(fread(image.rgb.data(), 1, image.rgb.size(), f));
+                    }
+
+                    fclose(f);
+
+                    return ok && image.rgb.size() == (size_t) image.width * image.height * 3;
+                }
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef ELOQUENT_EXTRA_LOG
+#define ELOQUENT_EXTRA_LOG
+
+// ESP-IDF logging on the ESP32, stderr on the host
+#if defined(ESP_PLATFORM)
+#include <esp_log.h>
+#else
+#include "./host/esp_log.h"
+#endif
+
+#endif
@@ -1,8 +1,8 @@
 #ifndef ELOQUENT_EXTRA_TIME_BENCHMARK
 #define ELOQUENT_EXTRA_TIME_BENCHMARK
 
-#include "esp_timer.h" // Include ESP-IDF header for timing
-#include "freertos/FreeRTOS.h" // Include FreeRTOS header for timing
+#include <stddef.h>
+#include "./clock.h"
 
 namespace Eloquent {
     namespace Extra {
@@ -17,14 +17,14 @@ namespace Eloquent {
                  * Start timer
                  */
                 void start() {
-                    timeStart = esp_timer_get_time(); // Use ESP-IDF's esp_timer_get_time() instead of micros()
+                    timeStart = Clock::micros();
                 }
 
                 /**
                  * Stop timer
                  */
                 size_t stop() {
-                    elapsedInMicros = esp_timer_get_time() - timeStart; // Use ESP-IDF's esp_timer_get_time() instead of micros()
+                    elapsedInMicros = Clock::micros() - timeStart;
 
                     return millis();
                 }
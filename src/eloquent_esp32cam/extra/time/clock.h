@@ -0,0 +1,44 @@
+#ifndef ELOQUENT_EXTRA_TIME_CLOCK
+#define ELOQUENT_EXTRA_TIME_CLOCK
+
+#include <stdint.h>
+
+#if defined(ESP_PLATFORM)
+#include "esp_timer.h"
+#else
+#include <chrono>
+#endif
+
+namespace Eloquent {
+    namespace Extra {
+        namespace Time {
+            /**
+             * Monotonic clock.
+             * esp_timer on the ESP32, steady clock on the host
+             */
+            class Clock {
+            public:
+                /**
+                 * Get current timestamp in micros
+                 */
+                static int64_t micros() {
+#if defined(ESP_PLATFORM)
+                    return esp_timer_get_time();
+#else
+                    return std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+                }
+
+                /**
+                 * Get current timestamp in millis
+                 */
+                static int64_t millis() {
+                    return micros() / 1000;
+                }
+            };
+        }
+    }
+}
+
+#endif
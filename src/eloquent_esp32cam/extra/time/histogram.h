@@ -0,0 +1,209 @@
+#ifndef ELOQUENT_EXTRA_TIME_HISTOGRAM
+#define ELOQUENT_EXTRA_TIME_HISTOGRAM
+
+#include <stdint.h>
+#include <atomic>
+
+namespace Eloquent {
+    namespace Extra {
+        namespace Time {
+            /**
+             * Fixed memory histogram of durations (in micros).
+             * Buckets are log-linear: 4 buckets per power of two,
+             * so percentiles are accurate to 25%.
+             * Meant for a single writer task, reads are safe from any task.
+             * Other tasks clear it with requestReset()
+             */
+            class Histogram {
+            public:
+                // durations up to 2^26 us (~67 s), longer ones fall in the last bucket
+                static const uint8_t maxOctave = 26;
+                static const uint8_t numBuckets = 4 * maxOctave;
+
+                /**
+                 * Constructor
+                 */
+                Histogram() : _resetPending(false) {
+                    reset();
+                }
+
+                /**
+                 * Clear all samples.
+                 * Only from the writer task (see requestReset())
+                 */
+                void reset() {
+                    for (uint8_t i = 0; i < numBuckets; i++)
+                        _buckets[i].store(0, std::memory_order_relaxed);
+
+                    _count.store(0, std::memory_order_relaxed);
+                    _sum.store(0, std::memory_order_relaxed);
+                    _min.store(UINT32_MAX, std::memory_order_relaxed);
+                    _max.store(0, std::memory_order_relaxed);
+                    // readers see an empty histogram until here
+                    _resetPending.store(false, std::memory_order_release);
+                }
+
+                /**
+                 * Clear all samples from any task.
+                 * The writer clears them before its next sample,
+                 * until then the histogram reads as empty
+                 */
+                void requestReset() {
+                    _resetPending.store(true, std::memory_order_release);
+                }
+
+                /**
+                 * Add a sample
+                 */
+                void add(int64_t micros) {
+                    applyPendingReset();
+
+                    const uint32_t us = micros < 0 ? 0 : (micros > UINT32_MAX ? UINT32_MAX : (uint32_t) micros);
+                    const uint8_t i = bucketOf(us);
+
+                    // single writer: plain load + store is enough
+                    _buckets[i].store(_buckets[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    _sum.store(_sum.load(std::memory_order_relaxed) + us, std::memory_order_relaxed);
+
+                    if (us < _min.load(std::memory_order_relaxed))
+                        _min.store(us, std::memory_order_relaxed);
+
+                    if (us > _max.load(std::memory_order_relaxed))
+                        _max.store(us, std::memory_order_relaxed);
+
+                    _count.store(_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+                }
+
+                /**
+                 * Add all samples of another histogram
+                 * (e.g. to combine the histograms of several tasks)
+                 */
+                void merge(const Histogram& other) {
+                    applyPendingReset();
+
+                    if (other.count() == 0)
+                        return;
+
+                    for (uint8_t i = 0; i < numBuckets; i++)
+                        _buckets[i].store(_buckets[i].load(std::memory_order_relaxed) + other._buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+                    _sum.store(_sum.load(std::memory_order_relaxed) + other._sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+                    if (other.min() < _min.load(std::memory_order_relaxed))
+                        _min.store(other.min(), std::memory_order_relaxed);
+
+                    if (other.max() > _max.load(std::memory_order_relaxed))
+                        _max.store(other.max(), std::memory_order_relaxed);
+
+                    _count.store(_count.load(std::memory_order_relaxed) + other.count(), std::memory_order_release);
+                }
+
+                /**
+                 * Get number of samples
+                 */
+                uint32_t count() const {
+                    if (_resetPending.load(std::memory_order_acquire))
+                        return 0;
+
+                    return _count.load(std::memory_order_acquire);
+                }
+
+                /**
+                 * Get shortest sample
+                 */
+                uint32_t min() const {
+                    return count() > 0 ? _min.load(std::memory_order_relaxed) : 0;
+                }
+
+                /**
+                 * Get longest sample
+                 */
+                uint32_t max() const {
+                    return count() > 0 ? _max.load(std::memory_order_relaxed) : 0;
+                }
+
+                /**
+                 * Get average duration
+                 */
+                uint32_t mean() const {
+                    const uint32_t n = count();
+
+                    return n > 0 ? _sum.load(std::memory_order_relaxed) / n : 0;
+                }
+
+                /**
+                 * Get duration below which `percent` of the samples fall
+                 * (upper bound of the bucket, capped at max)
+                 */
+                uint32_t percentile(float percent) const {
+                    const uint32_t n = count();
+
+                    if (n == 0)
+                        return 0;
+
+                    const uint64_t rank = (uint64_t) ((percent / 100.0f) * n + 0.5f);
+                    uint64_t seen = 0;
+
+                    for (uint8_t i = 0; i < numBuckets; i++) {
+                        seen += _buckets[i].load(std::memory_order_relaxed);
+
+                        if (seen >= rank && seen > 0) {
+                            const uint32_t upper = upperBoundOf(i);
+
+                            return upper < max() ? upper : max();
+                        }
+                    }
+
+                    return max();
+                }
+
+            protected:
+                std::atomic<uint32_t> _buckets[numBuckets];
+                std::atomic<uint32_t> _count;
+                std::atomic<uint64_t> _sum;
+                std::atomic<uint32_t> _min;
+                std::atomic<uint32_t> _max;
+                std::atomic<bool> _resetPending;
+
+                /**
+                 * Clear the samples if another task asked to
+                 * (called by the writer only)
+                 */
+                void applyPendingReset() {
+                    if (_resetPending.load(std::memory_order_acquire))
+                        reset();
+                }
+
+                /**
+                 * Get bucket index of a duration
+                 */
+                static uint8_t bucketOf(uint32_t us) {
+                    if (us < 4)
+                        return us;
+
+                    const uint8_t octave = 31 - __builtin_clz(us);
+
+                    if (octave > maxOctave)
+                        return numBuckets - 1;
+
+                    return (octave - 1) * 4 + ((us >> (octave - 2)) & 3);
+                }
+
+                /**
+                 * Get largest duration that falls in the given bucket
+                 */
+                static uint32_t upperBoundOf(uint8_t i) {
+                    if (i < 4)
+                        return i;
+
+                    const uint8_t octave = i / 4 + 1;
+                    const uint32_t width = 1UL << (octave - 2);
+
+                    return (4 + (i % 4)) * width + width - 1;
+                }
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef ELOQUENT_EXTRA_TIME_PROFILER
+#define ELOQUENT_EXTRA_TIME_PROFILER
+
+#include <stdint.h>
+#include <stdio.h>
+#include "./histogram.h"
+#include "./clock.h"
+
+namespace Eloquent {
+    namespace Extra {
+        namespace Time {
+            /**
+             * Latency histogram for each named stage of a loop.
+             * Each stage should be recorded by a single task
+             */
+            template<uint8_t numStages>
+            class Profiler {
+            public:
+
+                /**
+                 * Constructor
+                 * @param names one name per stage
+                 */
+                Profiler(const char* const (&names)[numStages]) {
+                    for (uint8_t i = 0; i < numStages; i++)
+                        _names[i] = names[i];
+                }
+
+                /**
+                 * Get current timestamp in micros
+                 */
+                static int64_t now() {
+                    return Clock::micros();
+                }
+
+                /**
+                 * Record duration of stage
+                 */
+                void add(uint8_t stage, int64_t micros) {
+                    if (stage < numStages)
+                        _stages[stage].add(micros);
+                }
+
+                /**
+                 * Record time elapsed since `start` for stage
+                 * @return current timestamp, to chain stages
+                 */
+                int64_t since(uint8_t stage, int64_t start) {
+                    const int64_t end = now();
+
+                    add(stage, end - start);
+
+                    return end;
+                }
+
+                /**
+                 * Time given function as stage
+                 */
+                template<typename Callback>
+                void measure(uint8_t stage, Callback callback) {
+                    const int64_t start = now();
+
+                    callback();
+                    since(stage, start);
+                }
+
+                /**
+                 * Get histogram of stage
+                 */
+                const Histogram& operator[](uint8_t stage) const {
+                    return _stages[stage];
+                }
+
+                /**
+                 * Add all samples of another profiler with the same stages
+                 */
+                void merge(const Profiler& other) {
+                    for (uint8_t i = 0; i < numStages; i++)
+                        _stages[i].merge(other[i]);
+                }
+
+                /**
+                 * Clear all stages.
+                 * Safe from any task: each stage is cleared by the task
+                 * recording it, before its next sample
+                 */
+                void reset() {
+                    for (uint8_t i = 0; i < numStages; i++)
+                        _stages[i].requestReset();
+                }
+
+                /**
+                 * Print one line per stage (durations in micros)
+                 * @param print callback receiving each line
+                 */
+                template<typename Print>
+                void report(Print print) const {
+                    char line[96];
+
+                    snprintf(line, sizeof(line), "%-10s %8s %8s %8s %8s %8s %8s %8s\n", "stage", "n", "min", "mean", "p50", "p90", "p99", "max");
+                    print(line);
+
+                    for (uint8_t i = 0; i < numStages; i++) {
+                        const Histogram& h = _stages[i];
+
+                        snprintf(line, sizeof(line), "%-10s %8lu %8lu %8lu %8lu %8lu %8lu %8lu\n",
+                            _names[i],
+                            (unsigned long) h.count(),
+                            (unsigned long) h.min(),
+                            (unsigned long) h.mean(),
+                            (unsigned long) h.percentile(50),
+                            (unsigned long) h.percentile(90),
+                            (unsigned long) h.percentile(99),
+                            (unsigned long) h.max());
+                        print(line);
+                    }
+                }
+
+            protected:
+                const char *_names[numStages];
+                Histogram _stages[numStages];
+            };
+        }
+    }
+}
+
+#endif
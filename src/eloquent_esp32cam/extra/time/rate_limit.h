@@ -1,8 +1,10 @@
 #ifndef ELOQUENT_EXTRA_RATELIMIT
 #define ELOQUENT_EXTRA_RATELIMIT
 
-#include <esp_timer.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <string>
+#include "./clock.h"
 
 namespace Eloquent {
     namespace Extra {
@@ -26,7 +28,7 @@ namespace Eloquent {
                  * Test if debounce time has elapsed
                  */
                 operator bool() const {
-                    const uint64_t now = esp_timer_get_time() / 1000;
+                    const uint64_t now = Clock::millis();
 
                     return debounceTime == 0 || lastEvent == 0 || (now - lastEvent) >= debounceTime || lastEvent >= now;
                 }
@@ -105,7 +107,7 @@ namespace Eloquent {
                  * Update last event timestamp
                  */
                 inline void touch() {
-                    lastEvent = esp_timer_get_time() / 1000;
+                    lastEvent = Clock::millis();
                 }
 
                 /**
@@ -113,7 +115,7 @@ namespace Eloquent {
                  */
                 std::string getRetryInMessage() const {
                     return "Rate limit exceeded. Retry in " +
-                        std::to_string(debounceTime - (esp_timer_get_time() / 1000 - lastEvent)) + "ms";
+                        std::to_string(debounceTime - (Clock::millis() - lastEvent)) + "ms";
                 }
 
             protected:
@@ -0,0 +1,115 @@
+/**
+ * The app loop, shared by src/main/main.cpp (device) and tools/eval/pipeline.cpp (Linux).
+ *
+ * Capture runs on one core, the motion gate and yolo on the other. The position of
+ * the first object goes to an output callback: the UART on the device, stdout on Linux.
+ */
+#ifndef MAIN_APP_LOOP_H
+#define MAIN_APP_LOOP_H
+
+#include <espcamfinal_inferencing.h>
+#include <eloquent_esp32cam.h>
+#include <eloquent_esp32cam/edgeimpulse/yolo.h>
+#include <eloquent_esp32cam/edgeimpulse/motion_gate.h>
+#include <eloquent_esp32cam/extra/esp32/multiprocessing/pipeline.h>
+#include <eloquent_esp32cam/extra/time/profiler.h>
+#include <stdio.h>
+
+using eloq::camera;
+using eloq::ei::yolo;
+using Eloquent::Esp32cam::EdgeImpulse::MotionGate;
+using Eloquent::Extra::Esp32::Multiprocessing::Pipeline;
+using Eloquent::Extra::Time::Profiler;
+
+// capture on core 0, inference + output on core 1
+static Pipeline<camera_fb_t> pipeline("pipeline");
+
+// skip yolo while the scene is static, for at most 5 frames in a row
+static MotionGate<> gate;
+
+// latency of each stage
+// (byte swap and resampling happen while the DSP reads the frame)
+enum Stage { CAPTURE, MOTION, DSP, INVOKE, DECODE, NMS, OUTPUT, FRAME, NUM_STAGES };
+static const char* const stageNames[NUM_STAGES] = {"capture", "motion", "dsp", "invoke", "decode", "nms", "output", "frame"};
+static Profiler<NUM_STAGES> profiler(stageNames);
+
+// position of the first object: 'l', 'c', 'r', or 'n' if there is none
+static uint8_t pos = 'n';
+
+/**
+ * Capture a frame, timing the camera driver
+ */
+static camera_fb_t* capture() {
+    const int64_t start = Profiler<NUM_STAGES>::now();
+    camera_fb_t *frame = esp_camera_fb_get();
+
+    if (frame != NULL)
+        profiler.since(CAPTURE, start);
+
+    return frame;
+}
+
+/**
+ * Give a frame back to the camera driver
+ */
+static void release(camera_fb_t *frame) {
+    esp_camera_fb_return(frame);
+}
+
+/**
+ * Map the first object to a position
+ */
+static uint8_t position() {
+    if (!yolo.foundAnyObject())
+        return 'n';
+
+    if (yolo.first.cx <= 13)
+        return 'l';
+
+    return yolo.first.cx <= 19 ? 'c' : 'r';
+}
+
+/**
+ * Run yolo on the newest frame and call output(pos, ran).
+ * Static scenes skip yolo and output the last position again, with ran = false.
+ * Returns false if inference failed (nothing is output)
+ */
+template<typename Output>
+static bool processFrame(camera_fb_t *frame, Output output) {
+    const int64_t start = Profiler<NUM_STAGES>::now();
+    bool shouldRun;
+
+    profiler.measure(MOTION, [frame, &shouldRun]() { shouldRun = gate.shouldRun(frame); });
+
+    if (shouldRun) {
+        if (!yolo.run(frame).isOk())
+            return false;
+
+        const ei_impulse_result_timing_t &timing = yolo.result.timing;
+
+        pos = position();
+        profiler.add(DSP, timing.dsp_us);
+        profiler.add(INVOKE, timing.invoke_us);
+        profiler.add(DECODE, timing.postprocessing_us - timing.nms_us);
+        profiler.add(NMS, timing.nms_us);
+    }
+
+    profiler.measure(OUTPUT, [&output, shouldRun]() { output(pos, shouldRun); });
+    profiler.since(FRAME, start);
+
+    return true;
+}
+
+/**
+ * Print the latency of each stage and the motion gate counters, line by line
+ */
+template<typename Print>
+static void report(Print print) {
+    char stats[48];
+
+    profiler.report(print);
+    snprintf(stats, sizeof(stats), "motion gate: %lu skipped, %lu ran\n", (unsigned long) gate.skipped(), (unsigned long) gate.ran());
+    print(stats);
+}
+
+#endif
@@ -1,9 +1,8 @@
-#include <espcamfinal_inferencing.h>
-#include <eloquent_esp32cam.h>
-#include <eloquent_esp32cam/edgeimpulse/yolo.h>
+#include "app_loop.h"
 #include <esp_log.h>
 #include <driver/uart.h>
 #include <esp_heap_caps.h>
+#include <string.h>
 
 
 #ifndef RX
@@ -14,12 +13,46 @@
 #define TX 43
 #endif
 
-using eloq::camera;
-using eloq::ei::yolo;
-
 static const char *TAG = "main";
-uint8_t pos = 'n';
-uint8_t esp_data[7] = {0x5A, 0x9F, 0x3A, 0x41, 0x6F, pos, 0x00};
+uint8_t esp_data[7] = {0x5A, 0x9F, 0x3A, 0x41, 0x6F, 'n', 0x00};
+
+// send 'p' over UART to dump the latency of each stage, 'r' to reset them
+
+/**
+ * Write a line of text to the UART
+ */
+static void print(const char *line) {
+    uart_write_bytes(UART_NUM_0, line, strlen(line));
+}
+
+/**
+ * Handle commands received over UART
+ */
+static void readCommands() {
+    uint8_t command;
+
+    while (uart_read_bytes(UART_NUM_0, &command, 1, 0) == 1) {
+        if (command == 'p') {
+            report(print);
+        }
+        else if (command == 'r') {
+            profiler.reset();
+        }
+    }
+}
+
+/**
+ * Run yolo on the newest frame and send the position of the first object
+ * (static scenes resend the last position)
+ */
+static void detect(camera_fb_t *frame) {
+    readCommands();
+
+    processFrame(frame, [](uint8_t position, bool) {
+        esp_data[5] = position;
+        uart_write_bytes(UART_NUM_0, esp_data, sizeof(esp_data));
+    });
+}
 
 extern "C" void app_main() {
     // Initialize UART0 for debugging
@@ -38,61 +71,17 @@ extern "C" void app_main() {
     uart_set_pin(uart_num, TX, RX, -1, -1);
     uart_driver_install(uart_num, 1024 * 2 , 0, 0, NULL, 0);
     camera.resolution.yolo();
+    yolo.resident();
 
     while (!camera.begin().isOk());
     
     //ESP_LOGI(TAG, "Camera initialized successfully"); 
 
-    while (true) {
-        if (!camera.capture().isOk()) {
-            // ESP_LOGE(TAG, "Failed to capture frame: %s", camera.exception.toString().c_str());
-            vTaskDelay(10 / portTICK_PERIOD_MS); // Delay to avoid tight loop on failure
-            continue;
-        }
-         if (!yolo.run().isOk()) {
-            // ESP_LOGE(TAG, "YOLO inference failed: %s", yolo.exception.toString().c_str());
-            vTaskDelay(10 / portTICK_PERIOD_MS); // Delay to avoid tight loop on failure
-            continue;
-        }
-         if (!yolo.foundAnyObject()) {
-            pos = 'n';
-            //ESP_LOGI(TAG, "pposisi: %c", pos);
-            //uint8_t esp_data[7] = {0x5A, 0x9F, 0x3A, 0x41, 0x6F, pos, 0x00};
-            esp_data[5] = 'n';
-            uart_write_bytes(UART_NUM_0, esp_data, sizeof(esp_data));
-            vTaskDelay(10 / portTICK_PERIOD_MS); // Delay if no objects found
-            continue;
-        }
-
-/*         if (yolo.first.cx <= EI_CLASSIFIER_INPUT_WIDTH / 3) pos = 'l'; //esp_data[5] = 'l'; 
-        else if (yolo.first.cx <= EI_CLASSIFIER_INPUT_WIDTH * 2 / 3)  pos = 'c'; //esp_data[5] = 'c';
-        else pos = 'r';//esp_data[5] = 'r';  */
-
-        if (yolo.first.cx <= 13){
-            pos = 'l';
-        } else if (yolo.first.cx <= 19){
-            pos = 'c';
-        } else {
-            pos = 'r';
-        }
-
-        //ESP_LOGI(TAG, "pposisi: %c", pos);
-        //ESP_LOGI(TAG, "cx: %u", yolo.first.cx);
-
-        esp_data[5] = pos;
-        uart_write_bytes(UART_NUM_0, esp_data, sizeof(esp_data));
-
-/*          if (yolo.count() > 1) {
-            yolo.forEach([](int i, bbox_t bbox) {
-                if (bbox.cx <= EI_CLASSIFIER_INPUT_WIDTH / 3) esp_data[5] = 'l'; //pos = 'l';
-                else if (bbox.cx <= EI_CLASSIFIER_INPUT_WIDTH * 2 / 3)  esp_data[5] = 'c'; //pos = 'c';
-                else esp_data[5] = 'r'; //pos = 'r';
-                ESP_LOGI(TAG, "pposisi: %c", pos);
-                esp_data[5] = pos;
-                //uint8_t esp_data[7] = {0x5A, 0x9F, 0x3A, 0x41, 0x6F, pos, 0x00};
-                uart_write_bytes(UART_NUM_0, esp_data, sizeof(esp_data));
-            });
-        }  */ 
-        vTaskDelay(10 / portTICK_PERIOD_MS); // Delay between captures
-    }    
-}
\ No newline at end of file
+    pipeline
+        .onCapture(capture)
+        .onRelease(release)
+        .onFrame(detect)
+        .onCores(0, 1)
+        .withStackSize(4096, 8192)
+        .start();
+}
@@ -0,0 +1,581 @@
+/**
+ * Offline evaluation of the impulse on Linux.
+ *
+ * Runs the detector over every frame of a directory, spread across a pool of
+ * workers (one impulse handle each), then reports throughput, the latency of
+ * each stage and, given a label file, the mAP of the detections.
+ *
+ * Frames are:
+ *   - .ppm (binary P6, 8 bit)
+ *   - .rgb565 raw big endian RGB565, as returned by the camera (needs --width, --height)
+ *   - .rgb888 raw RGB888 (needs --width, --height)
+ * Every frame is converted to RGB565 and resampled like on the device, so the
+ * features match what the camera pipeline feeds the model.
+ *
+ * The label file has one object per line, in frame pixels:
+ *   <frame file name> <label> <x> <y> <width> <height>
+ * Frames without objects don't need a line. Lines starting with # are skipped.
+ * --detections writes the detections in the same format, with the score appended.
+ *
+ * Usage:
+ *   eval <frames dir> [--labels file] [--detections file] [--threads n] [--width w --height h] [--iou t]
+ */
+#include <espcamfinal_inferencing.h>
+#include <eloquent_esp32cam/edgeimpulse/resampler.h>
+#include <eloquent_esp32cam/extra/time/profiler.h>
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <dirent.h>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Eloquent::Esp32cam::EdgeImpulse::Resampler;
+using Eloquent::Extra::Time::Profiler;
+
+enum Stage { DSP, INVOKE, DECODE, NMS, FRAME, NUM_STAGES };
+static const char* const stageNames[NUM_STAGES] = {"dsp", "invoke", "decode", "nms", "frame"};
+
+typedef Resampler<EI_CLASSIFIER_INPUT_WIDTH, EI_CLASSIFIER_INPUT_HEIGHT> FrameResampler;
+
+/**
+ * Frame as the camera returns it (big endian RGB565)
+ */
+struct Frame {
+    std::string name;
+    uint16_t width;
+    uint16_t height;
+    std::vector<uint8_t> rgb565;
+};
+
+/**
+ * Object box in frame pixels
+ */
+struct Box {
+    std::string label;
+    float score;
+    float x;
+    float y;
+    float width;
+    float height;
+};
+
+/**
+ * State of a worker thread, only touched by that thread until it's joined
+ */
+struct Worker {
+    Worker() : profiler(stageNames), errors(0) {}
+
+    std::thread thread;
+    Profiler<NUM_STAGES> profiler;
+    FrameResampler resampler;
+    ei_impulse_result_t result;
+    size_t errors;
+};
+
+struct Options {
+    const char *dir = NULL;
+    const char *labels = NULL;
+    const char *detections = NULL;
+    unsigned threads = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    float iou = 0.5f;
+};
+
+static bool endsWith(const std::string &s, const char *suffix) {
+    const size_t n = strlen(suffix);
+
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+/**
+ * Append a RGB888 pixel as big endian RGB565
+ */
+static inline void pushRGB565(std::vector<uint8_t> &out, uint8_t r, uint8_t g, uint8_t b) {
+    const uint16_t pixel = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+
+    out.push_back(pixel >> 8);
+    out.push_back(pixel & 0xFF);
+}
+
+static bool readFile(const std::string &path, std::vector<uint8_t> &data) {
+    FILE *f = fopen(path.c_str(), "rb");
+
+    if (f == NULL)
+        return false;
+
+    fseek(f, 0, SEEK_END);
+    data.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+
+    const bool ok = fread(data.data(), 1, data.size(), f) == data.size();
+
+    fclose(f);
+
+    return ok;
+}
+
+/**
+ * Read the next number of a PPM header, skipping whitespace and comments
+ */
+static bool ppmNumber(const std::vector<uint8_t> &data, size_t &pos, uint32_t &value) {
+    while (pos < data.size()) {
+        if (data[pos] == '#') {
+            while (pos < data.size() && data[pos] != '\n')
+                pos++;
+        }
+        else if (isspace(data[pos])) {
+            pos++;
+        }
+        else {
+            break;
+        }
+    }
+
+    if (pos >= data.size() || !isdigit(data[pos]))
+        return false;
+
+    value = 0;
+
+    while (pos < data.size() && isdigit(data[pos]))
+        value = value * 10 + (data[pos++] - '0');
+
+    return true;
+}
+
+/**
+ * Load a frame and convert it to RGB565
+ */
+static bool loadFrame(const std::string &dir, const std::string &name, const Options &options, Frame &frame) {
+    std::vector<uint8_t> data;
+
+    if (!readFile(dir + "/" + name, data)) {
+        ei_printf("ERR: Cannot read %s\n", name.c_str());
+        return false;
+    }
+
+    frame.name = name;
+
+    if (endsWith(name, ".ppm")) {
+        size_t pos = 2;
+        uint32_t width, height, maxval;
+
+        if (data.size() < 2 || data[0] != 'P' || data[1] != '6'
+            || !ppmNumber(data, pos, width) || !ppmNumber(data, pos, height) || !ppmNumber(data, pos, maxval)
+            || maxval != 255 || data.size() < pos + 1 + (size_t) width * height * 3) {
+            ei_printf("ERR: %s is not a 8 bit binary PPM\n", name.c_str());
+            return false;
+        }
+
+        // a single whitespace separates the header from the pixels
+        const uint8_t *rgb = data.data() + pos + 1;
+
+        frame.width = width;
+        frame.height = height;
+        frame.rgb565.reserve((size_t) width * height * 2);
+
+        for (size_t i = 0; i < (size_t) width * height; i++)
+            pushRGB565(frame.rgb565, rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+
+        return true;
+    }
+
+    const bool is565 = endsWith(name, ".rgb565");
+    const size_t bpp = is565 ? 2 : 3;
+
+    if (options.width == 0 || options.height == 0) {
+        ei_printf("ERR: Raw frames need --width and --height\n");
+        return false;
+    }
+
+    if (data.size() != (size_t) options.width * options.height * bpp) {
+        ei_printf("ERR: %s is %u bytes, expected %u\n", name.c_str(),
+            (unsigned) data.size(), (unsigned) (options.width * options.height * bpp));
+        return false;
+    }
+
+    frame.width = options.width;
+    frame.height = options.height;
+
+    if (is565) {
+        frame.rgb565.swap(data);
+        return true;
+    }
+
+    frame.rgb565.reserve((size_t) frame.width * frame.height * 2);
+
+    for (size_t i = 0; i < (size_t) frame.width * frame.height; i++)
+        pushRGB565(frame.rgb565, data[i * 3], data[i * 3 + 1], data[i * 3 + 2]);
+
+    return true;
+}
+
+static bool loadFrames(const Options &options, std::vector<Frame> &frames) {
+    DIR *dir = opendir(options.dir);
+    std::vector<std::string> names;
+
+    if (dir == NULL) {
+        ei_printf("ERR: Cannot open %s\n", options.dir);
+        return false;
+    }
+
+    while (struct dirent *entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+
+        if (endsWith(name, ".ppm") || endsWith(name, ".rgb565") || endsWith(name, ".rgb888"))
+            names.push_back(name);
+    }
+
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    frames.resize(names.size());
+
+    for (size_t i = 0; i < names.size(); i++) {
+        if (!loadFrame(options.dir, names[i], options, frames[i]))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Load ground truth boxes, by frame name
+ */
+static bool loadLabels(const char *path, std::map<std::string, std::vector<Box>> &labels) {
+    FILE *f = fopen(path, "r");
+    char line[512];
+    size_t lineNumber = 0;
+
+    if (f == NULL) {
+        ei_printf("ERR: Cannot open %s\n", path);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        char name[256];
+        char label[128];
+        Box box;
+
+        lineNumber++;
+
+        if (line[strspn(line, " \t\r\n")] == '\0' || line[strspn(line, " \t")] == '#')
+            continue;
+
+        // a trailing score (detections file) is ignored
+        if (sscanf(line, "%255s %127s %f %f %f %f", name, label, &box.x, &box.y, &box.width, &box.height) != 6) {
+            ei_printf("ERR: %s:%u should be <frame> <label> <x> <y> <width> <height>\n", path, (unsigned) lineNumber);
+            fclose(f);
+            return false;
+        }
+
+        box.label = label;
+        box.score = 1;
+        labels[name].push_back(box);
+    }
+
+    fclose(f);
+
+    return true;
+}
+
+/**
+ * Run the impulse on frames until none are left
+ */
+static void work(Worker *worker, const std::vector<Frame> *frames, std::atomic<size_t> *next, std::vector<std::vector<Box>> *detections) {
+    // each worker owns a handle, so inferences don't share any state
+    ei_impulse_handle_t handle(ei_default_impulse.impulse);
+    ei_impulse_result_t &result = worker->result;
+
+    run_classifier_resident_init(&handle);
+
+    for (size_t i = next->fetch_add(1); i < frames->size(); i = next->fetch_add(1)) {
+        const Frame &frame = (*frames)[i];
+        signal_t signal;
+
+        worker->resampler.update(frame.width, frame.height);
+        signal.total_length = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+        signal.get_data = [worker, &frame](size_t offset, size_t length, float *out) {
+            worker->resampler.sample(frame.rgb565.data(), offset, length, [out](size_t i, uint8_t r, uint8_t g, uint8_t b) {
+#if EI_CLASSIFIER_NN_INPUT_FRAME_SIZE > EI_CLASSIFIER_RAW_SAMPLE_COUNT
+                out[i] = (r << 16) | (g << 8) | b;
+#else
+                const uint32_t gray = std::min((r * 38 + g * 75 + b * 15) >> 7, 255);
+                out[i] = (gray << 16) | (gray << 8) | gray;
+#endif
+            });
+
+            return 0;
+        };
+
+        const int64_t start = Profiler<NUM_STAGES>::now();
+        const EI_IMPULSE_ERROR error = run_classifier(&handle, &signal, &result, false);
+
+        worker->profiler.since(FRAME, start);
+
+        if (error != EI_IMPULSE_OK) {
+            ei_printf("ERR: %s failed (%d)\n", frame.name.c_str(), error);
+            worker->errors++;
+            continue;
+        }
+
+        worker->profiler.add(DSP, result.timing.dsp_us);
+        worker->profiler.add(INVOKE, result.timing.invoke_us);
+        worker->profiler.add(DECODE, result.timing.postprocessing_us - result.timing.nms_us);
+        worker->profiler.add(NMS, result.timing.nms_us);
+
+        // boxes are in model input pixels
+        const float sx = (float) frame.width / EI_CLASSIFIER_INPUT_WIDTH;
+        const float sy = (float) frame.height / EI_CLASSIFIER_INPUT_HEIGHT;
+
+        for (uint32_t ix = 0; ix < result.bounding_boxes_count; ix++) {
+            const ei_impulse_result_bounding_box_t &bb = result.bounding_boxes[ix];
+
+            if (bb.value == 0)
+                continue;
+
+            (*detections)[i].push_back({ bb.label, bb.value, bb.x * sx, bb.y * sy, bb.width * sx, bb.height * sy });
+        }
+    }
+
+    run_classifier_resident_deinit(&handle);
+}
+
+static float iouOf(const Box &a, const Box &b) {
+    const float x1 = std::max(a.x, b.x);
+    const float y1 = std::max(a.y, b.y);
+    const float x2 = std::min(a.x + a.width, b.x + b.width);
+    const float y2 = std::min(a.y + a.height, b.y + b.height);
+    const float intersection = std::max(0.0f, x2 - x1) * std::max(0.0f, y2 - y1);
+    const float total = a.width * a.height + b.width * b.height - intersection;
+
+    return total > 0 ? intersection / total : 0;
+}
+
+/**
+ * Average precision of a label (area under the interpolated precision / recall curve,
+ * as in Pascal VOC 2010+ and COCO at a single IoU threshold)
+ */
+static float averagePrecision(
+    const char *label,
+    const std::vector<Frame> &frames,
+    const std::vector<std::vector<Box>> &detections,
+    std::map<std::string, std::vector<Box>> &labels,
+    float iouThreshold,
+    size_t *positives) {
+    struct Candidate { float score; size_t frame; const Box *box; };
+    std::vector<Candidate> candidates;
+
+    *positives = 0;
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        for (const Box &box : detections[i]) {
+            if (box.label == label)
+                candidates.push_back({ box.score, i, &box });
+        }
+
+        for (const Box &box : labels[frames[i].name]) {
+            if (box.label == label)
+                (*positives)++;
+        }
+    }
+
+    if (*positives == 0)
+        return 0;
+
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) { return a.score > b.score; });
+
+    // greedy matching: each ground truth box matches the best scoring detection only
+    std::map<const Box*, bool> matched;
+    std::vector<float> precision, recall;
+    size_t tp = 0, fp = 0;
+
+    for (const Candidate &candidate : candidates) {
+        const Box *best = NULL;
+        float bestIou = iouThreshold;
+
+        for (const Box &truth : labels[frames[candidate.frame].name]) {
+            if (truth.label != label)
+                continue;
+
+            const float iou = iouOf(*candidate.box, truth);
+
+            if (iou >= bestIou) {
+                best = &truth;
+                bestIou = iou;
+            }
+        }
+
+        if (best != NULL && !matched[best]) {
+            matched[best] = true;
+            tp++;
+        }
+        else {
+            fp++;
+        }
+
+        precision.push_back((float) tp / (tp + fp));
+        recall.push_back((float) tp / *positives);
+    }
+
+    float ap = 0;
+    float previousRecall = 0;
+
+    for (size_t i = 0; i < precision.size(); i++) {
+        float interpolated = 0;
+
+        for (size_t j = i; j < precision.size(); j++)
+            interpolated = std::max(interpolated, precision[j]);
+
+        ap += (recall[i] - previousRecall) * interpolated;
+        previousRecall = recall[i];
+    }
+
+    return ap;
+}
+
+/**
+ * Write detections in the label file format, with the score appended
+ */
+static bool saveDetections(const char *path, const std::vector<Frame> &frames, const std::vector<std::vector<Box>> &detections) {
+    FILE *f = fopen(path, "w");
+
+    if (f == NULL) {
+        ei_printf("ERR: Cannot write %s\n", path);
+        return false;
+    }
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        for (const Box &box : detections[i])
+            fprintf(f, "%s %s %.1f %.1f %.1f %.1f %.5f\n", frames[i].name.c_str(), box.label.c_str(), box.x, box.y, box.width, box.height, box.score);
+    }
+
+    fclose(f);
+
+    return true;
+}
+
+static void printUsage() {
+    ei_printf("Usage: eval <frames dir> [--labels file] [--detections file] [--threads n] [--width w --height h] [--iou t]\n");
+}
+
+static bool parseOptions(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+
+        if (strcmp(argv[i], "--labels") == 0 && hasValue)
+            options.labels = argv[++i];
+        else if (strcmp(argv[i], "--detections") == 0 && hasValue)
+            options.detections = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--width") == 0 && hasValue)
+            options.width = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--height") == 0 && hasValue)
+            options.height = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--iou") == 0 && hasValue)
+            options.iou = atof(argv[++i]);
+        else if (argv[i][0] != '-' && options.dir == NULL)
+            options.dir = argv[i];
+        else
+            return false;
+    }
+
+    return options.dir != NULL;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    std::vector<Frame> frames;
+    std::map<std::string, std::vector<Box>> labels;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    if (!loadFrames(options, frames) || (options.labels && !loadLabels(options.labels, labels)))
+        return 1;
+
+    if (frames.empty()) {
+        ei_printf("ERR: No frames in %s\n", options.dir);
+        return 1;
+    }
+
+    if (options.threads == 0)
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+#if EI_CLASSIFIER_COMPILED == 1
+    // the EON compiled graph is a single global instance, so inferences can't overlap
+    if (options.threads > 1) {
+        ei_printf("WARN: EON compiled models run on a single worker, build with EI_CLASSIFIER_COMPILED 0 to use %u\n", options.threads);
+        options.threads = 1;
+    }
+#endif
+
+    options.threads = std::min<size_t>(options.threads, frames.size());
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::vector<Box>> detections(frames.size());
+    std::atomic<size_t> next(0);
+
+    for (unsigned i = 0; i < options.threads; i++)
+        workers.emplace_back(new Worker());
+
+    const int64_t start = Profiler<NUM_STAGES>::now();
+
+    for (auto &worker : workers)
+        worker->thread = std::thread(work, worker.get(), &frames, &next, &detections);
+
+    Profiler<NUM_STAGES> profiler(stageNames);
+    size_t errors = 0;
+
+    for (auto &worker : workers) {
+        worker->thread.join();
+        profiler.merge(worker->profiler);
+        errors += worker->errors;
+    }
+
+    const int64_t elapsed = Profiler<NUM_STAGES>::now() - start;
+
+    ei_printf("%u frames on %u workers in %.2f s: %.1f frames/sec",
+        (unsigned) frames.size(), options.threads, elapsed / 1e6, frames.size() * 1e6 / (elapsed > 0 ? elapsed : 1));
+    ei_printf(errors > 0 ? " (%u failed)\n" : "\n", (unsigned) errors);
+    profiler.report([](const char *line) { ei_printf("%s", line); });
+
+    if (options.detections && !saveDetections(options.detections, frames, detections))
+        return 1;
+
+    if (options.labels == NULL)
+        return errors > 0 ? 1 : 0;
+
+    float sum = 0;
+    size_t count = 0;
+
+    ei_printf("%-16s %8s %8s\n", "label", "objects", "AP");
+
+    for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+        const char *label = ei_classifier_inferencing_categories[i];
+        size_t positives;
+        const float ap = averagePrecision(label, frames, detections, labels, options.iou, &positives);
+
+        if (positives == 0) {
+            ei_printf("%-16s %8u %8s\n", label, 0, "-");
+            continue;
+        }
+
+        ei_printf("%-16s %8u %8.3f\n", label, (unsigned) positives, ap);
+        sum += ap;
+        count++;
+    }
+
+    ei_printf("mAP@%.2f: %.3f\n", options.iou, count > 0 ? sum / count : 0.0f);
+
+    return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * The app loop of src/main/main.cpp (src/main/app_loop.h), on Linux.
+ *
+ * Frames come from the simulated camera (see eloquent_esp32cam/extra/host/esp_camera.h):
+ * synthetic frames, or the .ppm files of a folder. Capture and inference run on
+ * two threads through the same code as on the device, the position byte goes to
+ * stdout instead of the UART. At the end, the latency of
+ * each stage is reported, so the whole loop can be profiled (perf, valgrind, TSan).
+ *
+ * Usage:
+ *   pipeline [--frames dir] [--count n] [--fps f] [--daemon]
+ *
+ * --daemon runs the yolo background daemon instead of the pipeline.
+ */
+#include <app_loop.h>
+#include <atomic>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using Eloquent::Extra::Esp32::Multiprocessing::Thread;
+using Eloquent::Extra::Host::FileFrames;
+
+static std::atomic<uint32_t> processed(0);
+
+/**
+ * Run yolo on the newest frame and print the position
+ */
+static void detect(camera_fb_t *frame) {
+    const bool ok = processFrame(frame, [](uint8_t position, bool ran) {
+        printf("%u %c%s\n", (unsigned) processed.load(), position, ran ? "" : " (gated)");
+    });
+
+    if (!ok)
+        fprintf(stderr, "E main: YOLO inference failed: %s\n", yolo.exception.toString().c_str());
+
+    processed++;
+}
+
+int main(int argc, char **argv) {
+    const char *folder = NULL;
+    uint32_t count = 100;
+    float fps = 0;
+    bool daemon = false;
+    std::unique_ptr<FileFrames> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            folder = argv[++i];
+        else if (!strcmp(argv[i], "--count") && i + 1 < argc)
+            count = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--fps") && i + 1 < argc)
+            fps = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--daemon"))
+            daemon = true;
+        else {
+            fprintf(stderr, "Usage: %s [--frames dir] [--count n] [--fps f] [--daemon]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (folder != NULL) {
+        files.reset(new FileFrames(folder));
+
+        if (files->count() == 0) {
+            fprintf(stderr, "No .ppm frames in %s\n", folder);
+            return 1;
+        }
+
+        Eloquent::Extra::Host::cameraDriver().source(files.get());
+    }
+
+    if (fps > 0)
+        Eloquent::Extra::Host::cameraDriver().fps(fps);
+
+    camera.resolution.yolo();
+    yolo.resident();
+
+    if (!camera.begin().isOk()) {
+        fprintf(stderr, "Cannot init camera: %s\n", camera.exception.toString().c_str());
+        return 1;
+    }
+
+    const int64_t start = Profiler<NUM_STAGES>::now();
+
+    if (daemon) {
+        yolo.daemon.whenYouSeeAny([](uint8_t i, bbox_t &bbox) {
+            printf("%u %s at %u, %u\n", (unsigned) processed.load(), bbox.label.c_str(), (unsigned) bbox.cx, (unsigned) bbox.cy);
+        });
+        yolo.daemon.whenYouDontSeeAnything([]() {
+            printf("%u nothing\n", (unsigned) processed.load());
+        });
+        yolo.daemon.start();
+
+        // the daemon waits 3 seconds before the first frame
+        while (Eloquent::Extra::Host::cameraDriver().captured() < count)
+            Thread::sleep(10);
+
+        yolo.daemon.stop();
+        processed = Eloquent::Extra::Host::cameraDriver().captured();
+    }
+    else {
+        pipeline
+            .onCapture(capture)
+            .onRelease(release)
+            .onFrame(detect)
+            .start();
+
+        while (processed < count)
+            Thread::sleep(10);
+
+        pipeline.stop();
+    }
+
+    const float elapsed = (Profiler<NUM_STAGES>::now() - start) / 1000000.0f;
+
+    fflush(stdout);
+    fprintf(stderr, "%u frames in %.2f s (%.1f FPS)\n", (unsigned) processed.load(), elapsed, processed / elapsed);
+    report([](const char *line) { fputs(line, stderr); });
+    camera.free();
+    esp_camera_deinit();
+
+    return 0;
+}
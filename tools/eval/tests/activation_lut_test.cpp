@@ -0,0 +1,209 @@
+/**
+ * LOGISTIC, TANH and HARD_SWISH lookup tables against the reference kernels.
+ *
+ * For random input/output quantization params, each op runs twice on the same
+ * input (every int8/uint8 code, then random bytes): once as registered, so
+ * Eval reads the 256-entry table built in Prepare, and once with persistent
+ * allocations failing during Prepare, so the op keeps the reference kernel
+ * (the same fallback as a full arena). Both outputs must be identical.
+ * uint8 has no reference kernel: its tables are checked against the int8
+ * reference run on the same codes shifted by -128, zero points included.
+ * The last lines time both paths on a 96x96x32 tensor.
+ *
+ * Usage:
+ *   activation_lut_test [trials] [seed]
+ */
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/micro_ops.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/test_helpers.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace tflite;
+
+enum Op { LOGISTIC, TANH, HARD_SWISH, NUM_OPS };
+static const char* const opNames[NUM_OPS] = {"logistic", "tanh", "hard_swish"};
+
+static TfLiteStatus (*prepareWithTable)(TfLiteContext*, TfLiteNode*) = nullptr;
+
+/**
+ * Prepare the op while the arena refuses persistent buffers: no table
+ */
+static TfLiteStatus prepareWithoutTable(TfLiteContext *context, TfLiteNode *node) {
+    void* (*allocate)(TfLiteContext*, size_t) = context->AllocatePersistentBuffer;
+
+    context->AllocatePersistentBuffer = [](TfLiteContext*, size_t) -> void* { return nullptr; };
+    const TfLiteStatus status = prepareWithTable(context, node);
+    context->AllocatePersistentBuffer = allocate;
+
+    return status;
+}
+
+static TfLiteRegistration registration(Op op) {
+    switch (op) {
+        case LOGISTIC: return Register_LOGISTIC();
+        case TANH: return ops::micro::Register_TANH();
+        default: return Register_HARD_SWISH();
+    }
+}
+
+static float uniform(float lo, float hi) {
+    return lo + (hi - lo) * (rand() / (float) RAND_MAX);
+}
+
+/**
+ * Run the op over input, fills output.
+ * Returns false if Prepare rejected the params.
+ * Times Invoke (best of 20) if us is not NULL
+ */
+static bool run(Op op, bool table, TfLiteType type, float inScale, int inZero, float outScale, int outZero,
+                const std::vector<uint8_t> &input, std::vector<uint8_t> &output, double *us = NULL) {
+    TfLiteRegistration reg = registration(op);
+
+    if (!table) {
+        prepareWithTable = reg.prepare;
+        reg.prepare = prepareWithoutTable;
+    }
+
+    int dimsData[2] = {1, (int) input.size()};
+    int inputs[2] = {1, 0};
+    int outputs[2] = {1, 1};
+    TfLiteIntArray *dims = testing::IntArrayFromInts(dimsData);
+    TfLiteTensor tensors[2] = {};
+
+    output.assign(input.size(), 0);
+    tensors[0].data.data = (void*) input.data();
+    tensors[1].data.data = output.data();
+
+    for (int i = 0; i < 2; i++) {
+        tensors[i].type = type;
+        tensors[i].dims = dims;
+        tensors[i].bytes = input.size();
+        tensors[i].allocation_type = kTfLiteMemNone;
+        tensors[i].params.scale = i ? outScale : inScale;
+        tensors[i].params.zero_point = i ? outZero : inZero;
+    }
+
+    micro::KernelRunner runner(reg, tensors, 2, testing::IntArrayFromInts(inputs), testing::IntArrayFromInts(outputs), nullptr);
+
+    if (runner.InitAndPrepare() != kTfLiteOk)
+        return false;
+
+    double best = 1e12;
+
+    for (int i = 0; i < (us != NULL ? 20 : 1); i++) {
+        const auto start = std::chrono::steady_clock::now();
+
+        if (runner.Invoke() != kTfLiteOk)
+            return false;
+
+        best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    if (us != NULL)
+        *us = best;
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const int trials = argc > 1 ? atoi(argv[1]) : 3000;
+    int compared[NUM_OPS] = {0};
+    int rejected[NUM_OPS] = {0};
+    int failures = 0;
+
+    srand(argc > 2 ? atoi(argv[2]) : 42);
+
+    for (int trial = 0; trial < trials; trial++) {
+        const Op op = (Op) (trial % NUM_OPS);
+        const TfLiteType type = (trial / NUM_OPS) % 2 ? kTfLiteUInt8 : kTfLiteInt8;
+        const int offset = type == kTfLiteUInt8 ? 128 : 0;
+        const float inScale = expf(uniform(logf(0.002f), logf(0.5f)));
+        const int inZero = (int) uniform(-100, 100) + offset;
+        float outScale = expf(uniform(logf(0.002f), logf(0.5f)));
+        int outZero = (int) uniform(-100, 100) + offset;
+        std::vector<uint8_t> input(256 + 1024);
+        std::vector<uint8_t> fromTable, fromReference;
+
+        // LOGISTIC and TANH only accept their fixed output quantization
+        if (op == LOGISTIC) {
+            outScale = 1 / 256.0f;
+            outZero = -128 + offset;
+        }
+        else if (op == TANH) {
+            outScale = 1 / 128.0f;
+            outZero = offset;
+        }
+
+        for (size_t i = 0; i < input.size(); i++)
+            input[i] = i < 256 ? i : rand();
+
+        const bool withTable = run(op, true, type, inScale, inZero, outScale, outZero, input, fromTable);
+        bool withReference;
+
+        if (type == kTfLiteUInt8) {
+            std::vector<uint8_t> shifted(input);
+
+            for (uint8_t &value : shifted)
+                value ^= 0x80;
+
+            withReference = run(op, false, kTfLiteInt8, inScale, inZero - 128, outScale, outZero - 128, shifted, fromReference);
+
+            for (uint8_t &value : fromReference)
+                value ^= 0x80;
+        }
+        else {
+            withReference = run(op, false, type, inScale, inZero, outScale, outZero, input, fromReference);
+        }
+
+        if (withTable != withReference) {
+            printf("%s %s scale %g zero %d -> scale %g zero %d: Prepare %s only with the table\n",
+                   opNames[op], TfLiteTypeGetName(type), inScale, inZero, outScale, outZero, withTable ? "passes" : "fails");
+            failures++;
+            continue;
+        }
+
+        if (!withTable) {
+            rejected[op]++;
+            continue;
+        }
+
+        compared[op]++;
+
+        for (size_t i = 0; i < input.size(); i++) {
+            if (fromTable[i] != fromReference[i]) {
+                printf("%s %s scale %g zero %d -> scale %g zero %d: input %d gives %d, reference %d\n",
+                       opNames[op], TfLiteTypeGetName(type), inScale, inZero, outScale, outZero,
+                       input[i], fromTable[i], fromReference[i]);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    for (int op = 0; op < NUM_OPS; op++)
+        printf("%s: %d param sets compared, %d rejected by Prepare\n", opNames[op], compared[op], rejected[op]);
+
+    std::vector<uint8_t> big(96 * 96 * 32), out;
+
+    for (uint8_t &value : big)
+        value = rand();
+
+    for (int op = 0; op < NUM_OPS; op++) {
+        const float outScale = op == LOGISTIC ? 1 / 256.0f : (op == TANH ? 1 / 128.0f : 0.03f);
+        const int outZero = op == LOGISTIC ? -128 : (op == TANH ? 0 : -20);
+        double tableUs = 0, referenceUs = 0;
+
+        run((Op) op, true, kTfLiteInt8, 0.05f, 3, outScale, outZero, big, out, &tableUs);
+        run((Op) op, false, kTfLiteInt8, 0.05f, 3, outScale, outZero, big, out, &referenceUs);
+        printf("%s int8, %zu elements: table %.1f us, reference %.1f us\n", opNames[op], big.size(), tableUs, referenceUs);
+    }
+
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+
+    return failures ? 1 : 0;
+}
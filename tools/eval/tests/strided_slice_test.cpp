@@ -0,0 +1,290 @@
+/**
+ * STRIDED_SLICE fast paths against reference_ops::StridedSlice.
+ *
+ * Random 1D-4D slices (negative and out of range indices, masks, shrunk axes,
+ * negative strides) run through the registered kernel, which plans a
+ * memcpy/row/gather copy in Eval, and through the reference kernel.
+ * Both outputs must be identical. The last lines time both on the slices
+ * of the YOLOv5 focus layer, on a channel slice of a detection head and on
+ * a small slice where planning dominates.
+ *
+ * Usage:
+ *   strided_slice_test [trials] [seed]
+ */
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/micro_ops.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/test_helpers.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/strided_slice.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace tflite;
+
+struct Slice {
+    int dims;
+    int shape[4];
+    int begin[4];
+    int end[4];
+    int strides[4];
+    TfLiteStridedSliceParams params;
+};
+
+static int between(int lo, int hi) {
+    return lo + rand() % (hi - lo + 1);
+}
+
+static StridedSliceParams referenceParams(const Slice &slice) {
+    StridedSliceParams params = {};
+
+    params.start_indices_count = slice.dims;
+    params.stop_indices_count = slice.dims;
+    params.strides_count = slice.dims;
+
+    for (int i = 0; i < slice.dims; i++) {
+        params.start_indices[i] = slice.begin[i];
+        params.stop_indices[i] = slice.end[i];
+        params.strides[i] = slice.strides[i];
+    }
+
+    params.begin_mask = slice.params.begin_mask;
+    params.end_mask = slice.params.end_mask;
+    params.shrink_axis_mask = slice.params.shrink_axis_mask;
+
+    return params;
+}
+
+/**
+ * Output shape, like the converter computes it
+ */
+static std::vector<int> outputShape(const Slice &slice) {
+    const StridedSliceParams params = referenceParams(slice);
+    const RuntimeShape shape(slice.dims, slice.shape);
+    std::vector<int> output;
+
+    for (int axis = 0; axis < slice.dims; axis++) {
+        if (slice.params.shrink_axis_mask & (1 << axis))
+            continue;
+
+        const int begin = strided_slice::StartForAxis(params, shape, axis);
+        const int end = strided_slice::StopForAxis(params, shape, axis, begin);
+
+        output.push_back(std::max(0, (int) ceilf((end - begin) / (float) slice.strides[axis])));
+    }
+
+    return output;
+}
+
+/**
+ * Run the kernel, fills output.
+ * Times Invoke (best of 20) if us is not NULL
+ */
+template <typename T>
+static bool run(const Slice &slice, TfLiteType type, const std::vector<T> &input, std::vector<T> &output, double *us = NULL) {
+    const TfLiteRegistration reg = Register_STRIDED_SLICE();
+    const std::vector<int> outShape = outputShape(slice);
+    int inDims[5] = {slice.dims};
+    int outDims[5] = {(int) outShape.size()};
+    int indexDims[2] = {1, slice.dims};
+    int inputs[5] = {4, 0, 1, 2, 3};
+    int outputs[2] = {1, 4};
+    int begin[4], end[4], strides[4];
+    size_t outSize = 1;
+    TfLiteTensor tensors[5] = {};
+
+    memcpy(inDims + 1, slice.shape, slice.dims * sizeof(int));
+    memcpy(begin, slice.begin, sizeof(begin));
+    memcpy(end, slice.end, sizeof(end));
+    memcpy(strides, slice.strides, sizeof(strides));
+
+    for (size_t i = 0; i < outShape.size(); i++) {
+        outDims[i + 1] = outShape[i];
+        outSize *= outShape[i];
+    }
+
+    output.assign(outSize, T());
+
+    void *data[5] = {(void*) input.data(), begin, end, strides, output.data()};
+    TfLiteIntArray *dims[5] = {
+        testing::IntArrayFromInts(inDims),
+        testing::IntArrayFromInts(indexDims),
+        testing::IntArrayFromInts(indexDims),
+        testing::IntArrayFromInts(indexDims),
+        testing::IntArrayFromInts(outDims)
+    };
+
+    for (int i = 0; i < 5; i++) {
+        const bool index = i >= 1 && i <= 3;
+
+        tensors[i].type = index ? kTfLiteInt32 : type;
+        tensors[i].data.data = data[i];
+        tensors[i].dims = dims[i];
+        tensors[i].bytes = index ? slice.dims * sizeof(int32_t) : (i ? outSize : input.size()) * sizeof(T);
+        tensors[i].allocation_type = index ? kTfLiteMmapRo : kTfLiteMemNone;
+    }
+
+    TfLiteStridedSliceParams params = slice.params;
+    micro::KernelRunner runner(reg, tensors, 5, testing::IntArrayFromInts(inputs), testing::IntArrayFromInts(outputs), &params);
+
+    if (runner.InitAndPrepare() != kTfLiteOk)
+        return false;
+
+    double best = 1e12;
+
+    for (int i = 0; i < (us != NULL ? 20 : 1); i++) {
+        const auto start = std::chrono::steady_clock::now();
+
+        if (runner.Invoke() != kTfLiteOk)
+            return false;
+
+        best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    if (us != NULL)
+        *us = best;
+
+    return true;
+}
+
+/**
+ * Run reference_ops::StridedSlice, fills output.
+ * Times it (best of 20) if us is not NULL
+ */
+template <typename T>
+static void reference(const Slice &slice, const std::vector<T> &input, std::vector<T> &output, double *us = NULL) {
+    const std::vector<int> outShape = outputShape(slice);
+    size_t outSize = 1;
+
+    for (int dim : outShape)
+        outSize *= dim;
+
+    output.assign(outSize, T());
+
+    double best = 1e12;
+
+    for (int i = 0; i < (us != NULL ? 20 : 1); i++) {
+        const auto start = std::chrono::steady_clock::now();
+
+        reference_ops::StridedSlice(referenceParams(slice),
+                                    RuntimeShape(slice.dims, slice.shape), input.data(),
+                                    RuntimeShape(outShape.size(), outShape.data()), output.data());
+        best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    if (us != NULL)
+        *us = best;
+}
+
+static Slice randomSlice() {
+    Slice slice = {};
+
+    slice.dims = between(1, 4);
+
+    for (int axis = 0; axis < slice.dims; axis++) {
+        const int size = between(1, 9);
+
+        slice.shape[axis] = size;
+        slice.begin[axis] = between(-size - 1, size + 1);
+        slice.end[axis] = between(-size - 1, size + 1);
+        // mostly positive strides, like the converted models
+        slice.strides[axis] = rand() % 5 ? between(1, 3) : -between(1, 3);
+
+        if (rand() % 4 == 0)
+            slice.params.begin_mask |= 1 << axis;
+
+        if (rand() % 4 == 0)
+            slice.params.end_mask |= 1 << axis;
+
+        // shrunk axes need a valid begin
+        if (rand() % 8 == 0 && !(slice.params.begin_mask & (1 << axis))) {
+            slice.begin[axis] = between(-size, size - 1);
+            slice.params.shrink_axis_mask |= 1 << axis;
+        }
+    }
+
+    return slice;
+}
+
+template <typename T>
+static int compare(const Slice &slice, TfLiteType type) {
+    size_t size = 1;
+
+    for (int axis = 0; axis < slice.dims; axis++)
+        size *= slice.shape[axis];
+
+    std::vector<T> input(size), output, expected;
+
+    for (size_t i = 0; i < size; i++)
+        input[i] = (T) (i * 37 + 11);
+
+    if (!run(slice, type, input, output)) {
+        printf("%s slice failed in Prepare/Eval\n", TfLiteTypeGetName(type));
+        return 1;
+    }
+
+    reference(slice, input, expected);
+
+    if (output.size() != expected.size() || memcmp(output.data(), expected.data(), output.size() * sizeof(T))) {
+        printf("%s %dD slice of [%d %d %d %d]: begin [%d %d %d %d] end [%d %d %d %d] strides [%d %d %d %d] masks %d %d %d differs from reference\n",
+               TfLiteTypeGetName(type), slice.dims,
+               slice.shape[0], slice.shape[1], slice.shape[2], slice.shape[3],
+               slice.begin[0], slice.begin[1], slice.begin[2], slice.begin[3],
+               slice.end[0], slice.end[1], slice.end[2], slice.end[3],
+               slice.strides[0], slice.strides[1], slice.strides[2], slice.strides[3],
+               slice.params.begin_mask, slice.params.end_mask, slice.params.shrink_axis_mask);
+        return 1;
+    }
+
+    return 0;
+}
+
+static void benchmark(const char *name, const Slice &slice) {
+    size_t size = 1;
+    double kernelUs = 0, referenceUs = 0;
+
+    for (int axis = 0; axis < slice.dims; axis++)
+        size *= slice.shape[axis];
+
+    std::vector<int8_t> input(size), output;
+
+    for (size_t i = 0; i < size; i++)
+        input[i] = (int8_t) i;
+
+    run(slice, kTfLiteInt8, input, output, &kernelUs);
+    reference(slice, input, output, &referenceUs);
+    printf("%s: kernel %.1f us, reference %.1f us\n", name, kernelUs, referenceUs);
+}
+
+int main(int argc, char **argv) {
+    const int trials = argc > 1 ? atoi(argv[1]) : 20000;
+    int failures = 0;
+
+    srand(argc > 2 ? atoi(argv[2]) : 42);
+
+    for (int trial = 0; trial < trials; trial++) {
+        const Slice slice = randomSlice();
+
+        switch (trial % 3) {
+            case 0: failures += compare<int8_t>(slice, kTfLiteInt8); break;
+            case 1: failures += compare<int16_t>(slice, kTfLiteInt16); break;
+            default: failures += compare<float>(slice, kTfLiteFloat32); break;
+        }
+    }
+
+    printf("%d slices compared\n", trials);
+
+    // x[:, ::2, ::2, :] and x[:, 1::2, ::2, :] of a 1x320x320x3 frame, 85 of 255 head channels
+    benchmark("focus 1x320x320x3 [:, ::2, ::2, :]", {4, {1, 320, 320, 3}, {0, 0, 0, 0}, {1, 320, 320, 3}, {1, 2, 2, 1}, {}});
+    benchmark("focus 1x320x320x3 [:, 1::2, ::2, :]", {4, {1, 320, 320, 3}, {0, 1, 0, 0}, {1, 320, 320, 3}, {1, 2, 2, 1}, {}});
+    benchmark("head 1x40x40x255 [..., 0:85]", {4, {1, 40, 40, 255}, {0, 0, 0, 0}, {1, 40, 40, 85}, {1, 1, 1, 1}, {}});
+    // small enough for the per-Eval planning to show
+    benchmark("small 1x4x4x8 [..., 0:4]", {4, {1, 4, 4, 8}, {0, 0, 0, 0}, {1, 4, 4, 4}, {1, 1, 1, 1}, {}});
+
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""
+Generate a minimal TFLite Micro op resolver for a model.
+
+Reads the operators used by a .tflite flatbuffer and writes:
+
+  - src/tflite-model/tflite-resolver.h, defining EI_TFLITE_RESOLVER as a
+    MicroMutableOpResolver<N> that only registers those operators (picked up
+    by classifier/inferencing_engines/tflite_micro.h instead of AllOpsResolver)
+  - optionally src/tflite-model/trained_model_ops_define.h, disabling every
+    EI_TFLITE_DISABLE_<OP>_{IN,OUT}_<TYPE> kernel path the model doesn't hit
+
+The operator -> Add*() mapping and the list of kernels that honour the
+EI_TFLITE_DISABLE_* macros are read from the SDK sources, so they follow the
+SDK version in the tree. No dependencies besides the Python 3 standard library.
+
+Usage:
+    python3 tools/generate_tflite_resolver.py path/to/trained.tflite [--ops-define]
+"""
+
+import argparse
+import os
+import re
+import sys
+
+import tflite_flatbuffer as fb
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), '..'))
+SDK = os.path.join(ROOT, 'src', 'edge-impulse-sdk')
+OUT_DIR = os.path.join(ROOT, 'src', 'tflite-model')
+
+SCHEMA_H = os.path.join(SDK, 'tensorflow', 'lite', 'schema', 'schema_generated.h')
+RESOLVER_H = os.path.join(SDK, 'tensorflow', 'lite', 'micro', 'micro_mutable_op_resolver.h')
+KERNELS_DIR = os.path.join(SDK, 'tensorflow', 'lite', 'micro', 'kernels')
+
+# TensorType values from the schema, with the suffixes used by EI_TFLITE_DISABLE_*
+DISABLE_TYPES = {0: 'F32', 3: 'U8', 6: 'BOOL', 7: 'I16', 9: 'I8'}
+
+LICENSE = '''/* Generated by Edge Impulse
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+'''
+
+
+def read_sdk_tables():
+    """Map builtin operator codes to their names and MicroMutableOpResolver methods"""
+    with open(SCHEMA_H) as f:
+        schema = f.read()
+    names = {}
+    for name, code in re.findall(r'\bBuiltinOperator_(\w+) = (-?\d+)', schema):
+        if name not in ('MIN', 'MAX'):
+            names[int(code)] = name
+
+    with open(RESOLVER_H) as f:
+        resolver = f.read()
+    adders = {}
+    starts = [m for m in re.finditer(r'TfLiteStatus (Add\w+)\(', resolver)]
+    for i, m in enumerate(starts):
+        end = starts[i + 1].start() if i + 1 < len(starts) else len(resolver)
+        op = re.search(r'AddBuiltin\(\s*BuiltinOperator_(\w+)', resolver[m.end():end])
+        if op and op.group(1) not in adders:
+            adders[op.group(1)] = m.group(1)
+
+    disables = set()
+    for dirpath, _, files in os.walk(KERNELS_DIR):
+        for file in files:
+            with open(os.path.join(dirpath, file), errors='ignore') as f:
+                disables.update(re.findall(r'EI_TFLITE_DISABLE_(\w+?)_(?:IN|OUT)_', f.read()))
+
+    return names, adders, disables
+
+
+def read_model(path, names):
+    """
+    Get the operators of all subgraphs, as {name: (input types, output types)}
+    and the list of custom operators
+    """
+    with open(path, 'rb') as f:
+        model = fb.read_model(f.read())
+
+    codes = []
+    for op_code in model.tables(fb.MODEL_OPERATOR_CODES):
+        builtin = fb.builtin_code(op_code)
+        custom = op_code.string(fb.OPERATOR_CODE_CUSTOM_CODE)
+        codes.append(('CUSTOM:' + custom) if custom else names.get(builtin, 'UNKNOWN_%d' % builtin))
+
+    ops = {}
+    for subgraph in model.tables(fb.MODEL_SUBGRAPHS):
+        tensor_types = [tensor.scalar(fb.TENSOR_TYPE, 'b') for tensor in subgraph.tables(fb.SUBGRAPH_TENSORS)]
+        for operator in subgraph.tables(fb.SUBGRAPH_OPERATORS):
+            name = codes[operator.scalar(fb.OPERATOR_OPCODE_INDEX, 'I')]
+            in_types, out_types = ops.setdefault(name, (set(), set()))
+            inputs = [i for i in operator.scalars(fb.OPERATOR_INPUTS, 'i') if i >= 0]
+            outputs = [i for i in operator.scalars(fb.OPERATOR_OUTPUTS, 'i') if i >= 0]
+            if inputs:
+                in_types.add(tensor_types[inputs[0]])
+            if outputs:
+                out_types.add(tensor_types[outputs[0]])
+
+    return ops
+
+
+def write_resolver(ops, adders):
+    builtins = sorted(op for op in ops if not op.startswith('CUSTOM:'))
+    customs = sorted(op[len('CUSTOM:'):] for op in ops if op.startswith('CUSTOM:'))
+
+    missing = [op for op in builtins if op not in adders]
+    if missing:
+        sys.exit('ERR: No MicroMutableOpResolver method for %s' % ', '.join(missing))
+    if customs:
+        print('WARN: Custom operators %s need to be added to the resolver by hand' % ', '.join(customs))
+
+    lines = [LICENSE]
+    lines.append('#ifndef _EI_CLASSIFIER_TFLITE_RESOLVER_H_')
+    lines.append('#define _EI_CLASSIFIER_TFLITE_RESOLVER_H_')
+    lines.append('')
+    lines.append('#include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"')
+    lines.append('')
+    lines.append('#define EI_TFLITE_RESOLVER_OPS_COUNT %d' % len(builtins))
+    lines.append('')
+    lines.append('/**')
+    lines.append(' * Resolver registering only the operators used by the model.')
+    lines.append(' * Built once, on first use (thread-safe static initialization),')
+    lines.append(' * and only read afterwards.')
+    lines.append(' */')
+    lines.append('static tflite::MicroMutableOpResolver<EI_TFLITE_RESOLVER_OPS_COUNT>& ei_tflite_model_resolver() {')
+    lines.append('    static tflite::MicroMutableOpResolver<EI_TFLITE_RESOLVER_OPS_COUNT> resolver;')
+    lines.append('    static const bool resolver_ready = []() {')
+    for op in builtins:
+        lines.append('        resolver.%s();' % adders[op])
+    lines.append('        return true;')
+    lines.append('    }();')
+    lines.append('    (void)resolver_ready;')
+    lines.append('')
+    lines.append('    return resolver;')
+    lines.append('}')
+    lines.append('')
+    lines.append('#define EI_TFLITE_RESOLVER tflite::MicroMutableOpResolver<EI_TFLITE_RESOLVER_OPS_COUNT>& resolver = ei_tflite_model_resolver();')
+    lines.append('')
+    lines.append('#endif // _EI_CLASSIFIER_TFLITE_RESOLVER_H_')
+
+    path = os.path.join(OUT_DIR, 'tflite-resolver.h')
+    with open(path, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+    print('Wrote %s (%d operators)' % (os.path.relpath(path, ROOT), len(builtins)))
+
+
+def write_ops_define(ops, disables):
+    lines = [LICENSE]
+    lines.append('#ifndef EI_TFLITE_MODEL_OPS_DEFINES_H')
+    lines.append('#define EI_TFLITE_MODEL_OPS_DEFINES_H')
+    lines.append('')
+    count = 0
+    for op in sorted(disables):
+        in_types, out_types = ops.get(op, (set(), set()))
+        for direction, used in (('IN', in_types), ('OUT', out_types)):
+            for code, suffix in sorted(DISABLE_TYPES.items(), key=lambda t: ['U8', 'I8', 'I16', 'F32', 'BOOL'].index(t[1])):
+                if code not in used:
+                    lines.append('#define %-48s 1' % ('EI_TFLITE_DISABLE_%s_%s_%s' % (op, direction, suffix)))
+                    count += 1
+    lines.append('')
+    lines.append('#endif // EI_TFLITE_MODEL_OPS_DEFINES_H')
+
+    path = os.path.join(OUT_DIR, 'trained_model_ops_define.h')
+    with open(path, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+    print('Wrote %s (%d kernel paths disabled)' % (os.path.relpath(path, ROOT), count))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate a minimal TFLite Micro op resolver for a model')
+    parser.add_argument('model', help='.tflite flatbuffer')
+    parser.add_argument('--ops-define', action='store_true',
+        help='also regenerate trained_model_ops_define.h for the data types used by the model')
+    args = parser.parse_args()
+
+    names, adders, disables = read_sdk_tables()
+    ops = read_model(args.model, names)
+
+    for op, (in_types, out_types) in sorted(ops.items()):
+        print('  %-28s in: %-12s out: %s' % (op,
+            ','.join(DISABLE_TYPES.get(t, str(t)) for t in sorted(in_types)),
+            ','.join(DISABLE_TYPES.get(t, str(t)) for t in sorted(out_types))))
+
+    write_resolver(ops, adders)
+    if args.ops_define:
+        write_ops_define(ops, disables)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,416 @@
+#!/usr/bin/env python3
+"""
+Plan the tensor arena of a .tflite model offline.
+
+Works out the lifetime of every activation tensor the same way the TFLite Micro
+allocator does (micro_allocation_info.cc), including the CONCATENATION inputs it
+aliases into their output (MarkConcatenationAliases), then places them with:
+
+  - the GreedyMemoryPlanner heuristic (largest first, first fit), as the baseline
+  - best fit over a few orderings (size, size x lifetime, lifetime, creation time),
+    which places each buffer in the smallest gap that holds it
+
+The smallest plan is written to the model as "OfflineMemoryAllocation"
+metadata. The interpreter reads it in AllocationInfoBuilder::GetOfflinePlannedOffsets,
+so AllocateTensors() only has to fit the kernels' scratch buffers around it.
+The plan is never larger than the greedy one, and the report tells how much
+arena_size can shrink.
+
+The allocator does not alias offline planned buffers, so the plan itself
+places the aliased inputs at their slice of the output and the memory saved by
+the aliasing is kept. The kernel skips copying inputs that already sit at their
+slice. Pass --no-concat-aliasing to give every input its own buffer.
+
+EON compiled models don't use the planner: this is for the interpreter engine
+(tflite_micro.h). Models with control flow (several subgraphs) are not supported.
+
+Usage:
+    python3 tools/plan_tflite_memory.py model.tflite [-o planned.tflite]
+"""
+
+import argparse
+import struct
+import sys
+
+import tflite_flatbuffer as fb
+
+ARENA_ALIGNMENT = 16  # MicroArenaBufferAlignment()
+ONLINE_PLANNED = -1   # kOnlinePlannedBuffer
+OFFLINE_METADATA = 'OfflineMemoryAllocation'
+
+BUILTIN_CONCATENATION = 2                # BuiltinOperator_CONCATENATION
+BUILTIN_OPTIONS_CONCATENATION = 10       # BuiltinOptions_ConcatenationOptions
+ACTIVATION_NONE = 0                      # ActivationFunctionType_NONE
+
+# Bytes per element of each TensorType (see TfLiteTypeSizeOf), None if not plannable
+TYPE_SIZES = {
+    0: 4, 1: 2, 2: 4, 3: 1, 4: 8, 5: None, 6: 1, 7: 2, 8: 8,
+    9: 1, 10: 8, 11: 16, 12: 8, 13: None, 14: None, 15: 4, 16: 2, 17: 1,
+}
+
+
+class Buffer:
+    def __init__(self, tensor, bytes, first, last):
+        self.tensor = tensor
+        self.bytes = bytes
+        self.size = align_up(bytes, ARENA_ALIGNMENT)
+        self.first = first
+        self.last = last
+        self.offset = None
+
+    def overlaps(self, other):
+        return self.first <= other.last and other.first <= self.last
+
+
+def align_up(n, alignment):
+    return (n + alignment - 1) // alignment * alignment
+
+
+def tensor_bytes(tensor):
+    """Bytes of the tensor data (see BytesRequiredForTensor), 0 if not plannable"""
+    type_size = TYPE_SIZES.get(tensor.scalar(fb.TENSOR_TYPE, 'b'))
+    if type_size is None:
+        return 0
+    elements = 1
+    for dim in tensor.scalars(fb.TENSOR_SHAPE, 'i'):
+        elements *= max(dim, 1)
+    return elements * type_size
+
+
+def read_buffers(model):
+    """Get the arena buffers of the model, one per activation tensor"""
+    subgraphs = model.tables(fb.MODEL_SUBGRAPHS)
+    if len(subgraphs) != 1:
+        sys.exit('ERR: Only models with a single subgraph are supported (found %d)' % len(subgraphs))
+
+    subgraph = subgraphs[0]
+    tensors = subgraph.tables(fb.SUBGRAPH_TENSORS)
+    model_buffers = model.tables(fb.MODEL_BUFFERS)
+
+    first = [None] * len(tensors)
+    last = [None] * len(tensors)
+
+    def created(i, scope):
+        if first[i] is None:
+            first[i] = scope
+
+    def used(i, scope):
+        last[i] = scope
+
+    # same scopes as AllocationInfoBuilder::MarkAllocationLifetimes
+    scope = 0
+    for i in subgraph.scalars(fb.SUBGRAPH_INPUTS, 'i'):
+        created(i, scope)
+        used(i, scope)
+
+    for op in subgraph.tables(fb.SUBGRAPH_OPERATORS):
+        scope += 1
+        outputs = [i for i in op.scalars(fb.OPERATOR_OUTPUTS, 'i') if i >= 0]
+        for i in outputs:
+            created(i, scope)
+        for i in op.scalars(fb.OPERATOR_INPUTS, 'i'):
+            if i >= 0:
+                used(i, scope)
+        for i in outputs:
+            used(i, scope)
+
+    for i in subgraph.scalars(fb.SUBGRAPH_OUTPUTS, 'i'):
+        created(i, scope)
+        used(i, scope)
+
+    buffers = []
+    for i, tensor in enumerate(tensors):
+        buffer_index = tensor.scalar(fb.TENSOR_BUFFER, 'I')
+        has_data = buffer_index < len(model_buffers) and model_buffers[buffer_index].vector_length(fb.BUFFER_DATA) > 0
+        type_size = TYPE_SIZES.get(tensor.scalar(fb.TENSOR_TYPE, 'b'))
+
+        # constants live in flash, variables are allocated persistently
+        if has_data or tensor.scalar(fb.TENSOR_IS_VARIABLE, 'B') or type_size is None or first[i] is None:
+            continue
+
+        size = tensor_bytes(tensor)
+        if size > 0:
+            buffers.append(Buffer(i, size, first[i], last[i]))
+
+    return len(tensors), buffers
+
+
+def same_representation(a, b):
+    """SameRepresentation() in micro_allocation_info.cc"""
+    if a.scalar(fb.TENSOR_TYPE, 'b') != b.scalar(fb.TENSOR_TYPE, 'b'):
+        return False
+    qa = a.table(fb.TENSOR_QUANTIZATION)
+    qb = b.table(fb.TENSOR_QUANTIZATION)
+    for field, fmt in ((fb.QUANTIZATION_SCALE, 'f'), (fb.QUANTIZATION_ZERO_POINT, 'q')):
+        if (qa.scalars(field, fmt) if qa else []) != (qb.scalars(field, fmt) if qb else []):
+            return False
+    return True
+
+
+def mark_concat_aliases(model, buffers):
+    """
+    AllocationInfoBuilder::MarkConcatenationAliases: inputs of a CONCATENATION
+    whose dimensions before the axis are all 1 are contiguous slices of the
+    output. They are not planned, the output lives as long as all of them.
+    Returns {input tensor: (output tensor, offset)}
+    """
+    subgraph = model.tables(fb.MODEL_SUBGRAPHS)[0]
+    tensors = subgraph.tables(fb.SUBGRAPH_TENSORS)
+    op_codes = model.tables(fb.MODEL_OPERATOR_CODES)
+    io = set(subgraph.scalars(fb.SUBGRAPH_INPUTS, 'i') + subgraph.scalars(fb.SUBGRAPH_OUTPUTS, 'i'))
+    by_tensor = {b.tensor: b for b in buffers}
+    aliases = {}
+
+    def try_alias(child, parent, offset):
+        c = by_tensor.get(child)
+        p = by_tensor.get(parent)
+        if (c is None or p is None or child == parent or child in aliases or parent in aliases or
+                offset % ARENA_ALIGNMENT != 0 or offset + c.bytes > p.bytes or child in io or
+                not same_representation(tensors[child], tensors[parent])):
+            return
+        # no chains: a buffer that already holds aliases stays planned
+        if any(target == child for target, _ in aliases.values()):
+            return
+        p.first = min(p.first, c.first)
+        p.last = max(p.last, c.last)
+        aliases[child] = (parent, offset)
+
+    for op in subgraph.tables(fb.SUBGRAPH_OPERATORS):
+        op_code = op_codes[op.scalar(fb.OPERATOR_OPCODE_INDEX, 'I')]
+        options = op.table(fb.OPERATOR_BUILTIN_OPTIONS)
+        outputs = op.scalars(fb.OPERATOR_OUTPUTS, 'i')
+        if (fb.builtin_code(op_code) != BUILTIN_CONCATENATION or options is None or
+                op.scalar(fb.OPERATOR_BUILTIN_OPTIONS_TYPE, 'B') != BUILTIN_OPTIONS_CONCATENATION or
+                options.scalar(fb.CONCATENATION_FUSED_ACTIVATION_FUNCTION, 'b') != ACTIVATION_NONE or
+                len(outputs) != 1):
+            continue
+
+        output = outputs[0]
+        dims = tensors[output].scalars(fb.TENSOR_SHAPE, 'i')
+        axis = options.scalar(fb.CONCATENATION_AXIS, 'i')
+        if axis < 0:
+            axis += len(dims)
+        if axis < 0 or axis >= len(dims) or any(d != 1 for d in dims[:axis]):
+            continue
+
+        offset = 0
+        for i in op.scalars(fb.OPERATOR_INPUTS, 'i'):
+            if i < 0:
+                break
+            try_alias(i, output, offset)
+            offset += tensor_bytes(tensors[i])
+
+    return aliases
+
+
+def plan_greedy(buffers):
+    """GreedyMemoryPlanner::CalculateOffsetsIfNeeded"""
+    placed = []
+    # online buffers are queued from the tail, so equal sizes go in reverse order
+    for buffer in sorted(reversed(buffers), key=lambda b: -b.size):
+        offset = 0
+        for other in sorted((p for p in placed if p.overlaps(buffer)), key=lambda p: p.offset):
+            if other.offset - offset >= buffer.size:
+                break
+            offset = max(offset, other.offset + other.size)
+        buffer.offset = offset
+        placed.append(buffer)
+    return {b.tensor: b.offset for b in buffers}
+
+
+def plan_best_fit(buffers, key):
+    """Place each buffer in the smallest gap that holds it"""
+    placed = []
+    for buffer in sorted(buffers, key=key):
+        best = None
+        end = 0
+        for other in sorted((p for p in placed if p.overlaps(buffer)), key=lambda p: p.offset):
+            gap = other.offset - end
+            if gap >= buffer.size and (best is None or gap < best[1]):
+                best = (end, gap)
+            end = max(end, other.offset + other.size)
+        buffer.offset = best[0] if best else end
+        placed.append(buffer)
+    return {b.tensor: b.offset for b in buffers}
+
+
+def peak(buffers, offsets):
+    return max((offsets[b.tensor] + b.size for b in buffers), default=0)
+
+
+def validate(buffers, offsets):
+    for i, a in enumerate(buffers):
+        for b in buffers[i + 1:]:
+            if a.overlaps(b) and offsets[a.tensor] < offsets[b.tensor] + b.size and offsets[b.tensor] < offsets[a.tensor] + a.size:
+                sys.exit('ERR: Tensors %d and %d overlap in the plan' % (a.tensor, b.tensor))
+
+
+class Prefix:
+    """
+    Flatbuffer objects written in front of an existing buffer.
+    Offsets are unsigned and point forward, so new objects can reference
+    objects written after them (by label) and anything in the original buffer
+    """
+
+    def __init__(self):
+        self.data = bytearray()
+        self.labels = {}
+        self.patches = []  # (position, target), target is ('old', position) or ('label', name)
+
+    def align(self, alignment, extra=0):
+        while (len(self.data) + extra) % alignment:
+            self.data.append(0)
+
+    def label(self, name, position):
+        self.labels[name] = position
+        return position
+
+    def ref(self, target):
+        self.align(4)
+        self.patches.append((len(self.data), target))
+        self.data += b'\0\0\0\0'
+
+    def table(self, fields):
+        """fields: [(index, 'u32' | 'ref', value)], returns the table position"""
+        self.align(2)
+        num_fields = max(index for index, _, _ in fields) + 1
+        vtable = len(self.data)
+        self.data += struct.pack('<HH', 4 + 2 * num_fields, 4 + 4 * len(fields))
+        slots = [0] * num_fields
+        for n, (index, _, _) in enumerate(fields):
+            slots[index] = 4 + 4 * n
+        self.data += struct.pack('<%dH' % num_fields, *slots)
+
+        self.align(4)
+        table = len(self.data)
+        self.data += struct.pack('<i', table - vtable)
+        for _, kind, value in fields:
+            if kind == 'ref':
+                self.ref(value)
+            else:
+                self.data += struct.pack('<I', value)
+        return table
+
+    def vector_of_refs(self, targets):
+        self.align(4)
+        position = len(self.data)
+        self.data += struct.pack('<I', len(targets))
+        for target in targets:
+            self.ref(target)
+        return position
+
+    def vector_of_bytes(self, payload, alignment=ARENA_ALIGNMENT):
+        self.align(alignment, 4)
+        position = len(self.data)
+        self.data += struct.pack('<I', len(payload)) + payload
+        return position
+
+    def string(self, text):
+        self.align(4)
+        position = len(self.data)
+        self.data += struct.pack('<I', len(text)) + text.encode('utf-8') + b'\0'
+        return position
+
+    def finish(self, old):
+        # keep the alignment of the original buffers
+        self.align(ARENA_ALIGNMENT)
+        shift = len(self.data)
+        for position, (kind, target) in self.patches:
+            absolute = target + shift if kind == 'old' else self.labels[target]
+            assert absolute > position
+            struct.pack_into('<I', self.data, position, absolute - position)
+        return bytes(self.data) + old
+
+
+def with_offline_plan(buf, model, tensor_count, offsets):
+    """Copy of the model with its OfflineMemoryAllocation metadata replaced"""
+    if model.num_fields() > 8:
+        sys.exit('ERR: Model has fields this tool does not know about')
+
+    plan = [1, 0, tensor_count] + [offsets.get(i, ONLINE_PLANNED) for i in range(tensor_count)]
+    payload = struct.pack('<%di' % len(plan), *plan)
+
+    buffers = model.tables(fb.MODEL_BUFFERS)
+    metadata = [m for m in model.tables(fb.MODEL_METADATA) if m.string(fb.METADATA_NAME) != OFFLINE_METADATA]
+
+    p = Prefix()
+    p.ref(('label', 'model'))
+    p.data += buf[4:8]  # file identifier
+
+    # new model table: same fields, except for the buffers and metadata vectors
+    model_fields = []
+    for index in range(model.num_fields()):
+        if index == fb.MODEL_VERSION and model.has(index):
+            model_fields.append((index, 'u32', model.scalar(index, 'I')))
+        elif index == fb.MODEL_BUFFERS:
+            model_fields.append((index, 'ref', ('label', 'buffers')))
+        elif index != fb.MODEL_METADATA and model.has(index):
+            model_fields.append((index, 'ref', ('old', model.indirect(index))))
+    model_fields.append((fb.MODEL_METADATA, 'ref', ('label', 'metadata')))
+    model_fields.sort()
+
+    p.label('model', p.table(model_fields))
+    p.label('buffers', p.vector_of_refs([('old', b.pos) for b in buffers] + [('label', 'plan_buffer')]))
+    p.label('metadata', p.vector_of_refs([('old', m.pos) for m in metadata] + [('label', 'plan_metadata')]))
+    p.label('plan_metadata', p.table([
+        (fb.METADATA_NAME, 'ref', ('label', 'plan_name')),
+        (fb.METADATA_BUFFER, 'u32', len(buffers)),
+    ]))
+    p.label('plan_name', p.string(OFFLINE_METADATA))
+    p.label('plan_buffer', p.table([(fb.BUFFER_DATA, 'ref', ('label', 'plan_data'))]))
+    p.label('plan_data', p.vector_of_bytes(payload))
+
+    return p.finish(buf)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Plan the tensor arena of a .tflite model offline')
+    parser.add_argument('model', help='.tflite flatbuffer')
+    parser.add_argument('-o', '--output', help='planned model (default: overwrite the input)')
+    parser.add_argument('--no-concat-aliasing', action='store_true',
+                        help='give CONCATENATION inputs their own buffer')
+    args = parser.parse_args()
+
+    with open(args.model, 'rb') as f:
+        buf = f.read()
+
+    model = fb.read_model(buf)
+    tensor_count, buffers = read_buffers(model)
+
+    aliases = {} if args.no_concat_aliasing else mark_concat_aliases(model, buffers)
+    if aliases:
+        print('  %d CONCATENATION inputs aliased into their output' % len(aliases))
+    buffers = [b for b in buffers if b.tensor not in aliases]
+
+    plans = [('greedy', plan_greedy(buffers))]
+    orderings = [
+        ('best fit by size', lambda b: (-b.size, b.first)),
+        ('best fit by size x lifetime', lambda b: (-b.size * (b.last - b.first + 1), -b.size)),
+        ('best fit by lifetime', lambda b: (-(b.last - b.first), -b.size)),
+        ('best fit by creation', lambda b: (b.first, -b.size)),
+    ]
+    for name, key in orderings:
+        plans.append((name, plan_best_fit(buffers, key)))
+
+    for name, offsets in plans:
+        validate(buffers, offsets)
+        for child, (parent, offset) in aliases.items():
+            offsets[child] = offsets[parent] + offset
+        print('  %-28s %8d bytes' % (name, peak(buffers, offsets)))
+
+    greedy_peak = peak(buffers, plans[0][1])
+    name, offsets = min(plans, key=lambda plan: peak(buffers, plan[1]))
+    planned_peak = peak(buffers, offsets)
+
+    output = args.output or args.model
+    with open(output, 'wb') as f:
+        f.write(with_offline_plan(buf, model, tensor_count, offsets))
+
+    print('Wrote %s: %d tensors planned with %s, %d bytes (greedy: %d bytes)' % (
+        output, len(buffers) + len(aliases), name, planned_peak, greedy_peak))
+    print('arena_size can shrink by %d bytes (scratch buffers are still planned at runtime)' % (
+        greedy_peak - planned_peak))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,140 @@
+"""
+Minimal reader for .tflite flatbuffers, shared by the model tools.
+Field indices follow tensorflow/lite/schema/schema_generated.h.
+"""
+
+import struct
+
+# Model
+MODEL_VERSION = 0
+MODEL_OPERATOR_CODES = 1
+MODEL_SUBGRAPHS = 2
+MODEL_DESCRIPTION = 3
+MODEL_BUFFERS = 4
+MODEL_METADATA = 6
+
+# SubGraph
+SUBGRAPH_TENSORS = 0
+SUBGRAPH_INPUTS = 1
+SUBGRAPH_OUTPUTS = 2
+SUBGRAPH_OPERATORS = 3
+
+# Tensor
+TENSOR_SHAPE = 0
+TENSOR_TYPE = 1
+TENSOR_BUFFER = 2
+TENSOR_QUANTIZATION = 4
+TENSOR_IS_VARIABLE = 5
+
+# QuantizationParameters
+QUANTIZATION_SCALE = 2
+QUANTIZATION_ZERO_POINT = 3
+
+# OperatorCode
+OPERATOR_CODE_DEPRECATED_BUILTIN_CODE = 0
+OPERATOR_CODE_CUSTOM_CODE = 1
+OPERATOR_CODE_BUILTIN_CODE = 3
+
+# Operator
+OPERATOR_OPCODE_INDEX = 0
+OPERATOR_INPUTS = 1
+OPERATOR_OUTPUTS = 2
+OPERATOR_BUILTIN_OPTIONS_TYPE = 3
+OPERATOR_BUILTIN_OPTIONS = 4
+
+# ConcatenationOptions
+CONCATENATION_AXIS = 0
+CONCATENATION_FUSED_ACTIVATION_FUNCTION = 1
+
+# Buffer
+BUFFER_DATA = 0
+
+# Metadata
+METADATA_NAME = 0
+METADATA_BUFFER = 1
+
+
+class Table:
+    """Read-only view over a flatbuffer table"""
+
+    def __init__(self, buf, pos):
+        self.buf = buf
+        self.pos = pos
+        vtable = pos - struct.unpack_from('<i', buf, pos)[0]
+        self.vtable = vtable
+        self.vtable_size = struct.unpack_from('<H', buf, vtable)[0]
+
+    def num_fields(self):
+        return (self.vtable_size - 4) // 2
+
+    def has(self, field):
+        return self._offset(field) != 0
+
+    def _offset(self, field):
+        entry = 4 + 2 * field
+        if entry >= self.vtable_size:
+            return 0
+        return struct.unpack_from('<H', self.buf, self.vtable + entry)[0]
+
+    def scalar(self, field, fmt, default=0):
+        off = self._offset(field)
+        if off == 0:
+            return default
+        return struct.unpack_from('<' + fmt, self.buf, self.pos + off)[0]
+
+    def indirect(self, field):
+        """Absolute position of the object an offset field points to (or None)"""
+        off = self._offset(field)
+        if off == 0:
+            return None
+        p = self.pos + off
+        return p + struct.unpack_from('<I', self.buf, p)[0]
+
+    def table(self, field):
+        """Sub-table (or union member) of the field, None if not set"""
+        p = self.indirect(field)
+        if p is None:
+            return None
+        return Table(self.buf, p)
+
+    def string(self, field):
+        p = self.indirect(field)
+        if p is None:
+            return None
+        n = struct.unpack_from('<I', self.buf, p)[0]
+        return self.buf[p + 4:p + 4 + n].decode('utf-8')
+
+    def tables(self, field):
+        p = self.indirect(field)
+        if p is None:
+            return []
+        n = struct.unpack_from('<I', self.buf, p)[0]
+        items = []
+        for i in range(n):
+            q = p + 4 + 4 * i
+            items.append(Table(self.buf, q + struct.unpack_from('<I', self.buf, q)[0]))
+        return items
+
+    def scalars(self, field, fmt):
+        p = self.indirect(field)
+        if p is None:
+            return []
+        n = struct.unpack_from('<I', self.buf, p)[0]
+        return list(struct.unpack_from('<%d%s' % (n, fmt), self.buf, p + 4))
+
+    def vector_length(self, field):
+        p = self.indirect(field)
+        if p is None:
+            return 0
+        return struct.unpack_from('<I', self.buf, p)[0]
+
+
+def builtin_code(op_code):
+    """Builtin operator of an OperatorCode, see GetBuiltinCode() in schema_utils.cc"""
+    return max(op_code.scalar(OPERATOR_CODE_BUILTIN_CODE, 'i'),
+               op_code.scalar(OPERATOR_CODE_DEPRECATED_BUILTIN_CODE, 'b'))
+
+
+def read_model(buf):
+    """Get the root Model table of a .tflite file"""
+    return Table(buf, struct.unpack_from('<I', buf, 0)[0])